@@ -24,6 +24,9 @@ endif()
 
 include(CMakePackageConfigHelpers)
 
+# The source of cxxopts-codegen, for cxxopts_generate_parser
+set(CXXOPTS_CODEGEN_SOURCE "${CMAKE_CURRENT_LIST_DIR}/../src/codegen.cpp" CACHE INTERNAL "")
+
 function(cxxopts_getversion version_arg)
     # Parse the current version from the cxxopts header
     file(STRINGS "${CMAKE_CURRENT_SOURCE_DIR}/include/cxxopts.hpp" cxxopts_version_defines
@@ -85,6 +88,48 @@ function(cxxopts_enable_warnings)
     set(CMAKE_CXX_FLAGS ${CMAKE_CXX_FLAGS} PARENT_SCOPE)
 endfunction()
 
+# Generates a header with a typed parser from a file of option specs, using
+# cxxopts-codegen, which is built the first time this is called. See
+# src/codegen.cpp for the format of the file. With TARGET, the header is
+# added to the target and its directory to the target's include path. WIDTH
+# sets the width of the help text, which is otherwise taken from the spec.
+#
+#   cxxopts_generate_parser(SPEC options.spec OUTPUT config.hpp TARGET app)
+function(cxxopts_generate_parser)
+    cmake_parse_arguments(CXXOPTS_GENERATE "" "SPEC;OUTPUT;TARGET;WIDTH" "" ${ARGN})
+    if(NOT CXXOPTS_GENERATE_SPEC OR NOT CXXOPTS_GENERATE_OUTPUT)
+        message(FATAL_ERROR "cxxopts_generate_parser needs SPEC and OUTPUT")
+    endif()
+
+    if(NOT TARGET cxxopts_codegen)
+        add_executable(cxxopts_codegen ${CXXOPTS_CODEGEN_SOURCE})
+        target_link_libraries(cxxopts_codegen cxxopts)
+        set_target_properties(cxxopts_codegen PROPERTIES OUTPUT_NAME cxxopts-codegen)
+    endif()
+
+    set(width_args)
+    if(CXXOPTS_GENERATE_WIDTH)
+        set(width_args --width "${CXXOPTS_GENERATE_WIDTH}")
+    endif()
+
+    get_filename_component(spec "${CXXOPTS_GENERATE_SPEC}" ABSOLUTE)
+    get_filename_component(output "${CXXOPTS_GENERATE_OUTPUT}" ABSOLUTE
+        BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+    get_filename_component(output_dir "${output}" DIRECTORY)
+
+    add_custom_command(
+        OUTPUT "${output}"
+        COMMAND cxxopts_codegen "${spec}" "${output}" ${width_args}
+        DEPENDS "${spec}" cxxopts_codegen
+        COMMENT "Generating the option parser ${CXXOPTS_GENERATE_OUTPUT}"
+        VERBATIM)
+
+    if(CXXOPTS_GENERATE_TARGET)
+        target_sources(${CXXOPTS_GENERATE_TARGET} PRIVATE "${output}")
+        target_include_directories(${CXXOPTS_GENERATE_TARGET} PRIVATE "${output_dir}")
+    endif()
+endfunction()
+
 # Helper function to ecapsulate install logic
 function(cxxopts_install_logic)
     if(NOT CXXOPTS_USE_UNICODE_HELP)
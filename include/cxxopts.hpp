@@ -42,17 +42,27 @@ THE SOFTWARE.
 #include <utility>
 #include <vector>
 #include <algorithm>
-#include <locale>
 
 #ifdef CXXOPTS_NO_EXCEPTIONS
 #include <iostream>
 #endif
 
-#if defined(__GNUC__) && !defined(__clang__)
-#  if (__GNUC__ * 10 + __GNUC_MINOR__) < 49
-#    define CXXOPTS_NO_REGEX true
+// Allows large lists to be converted on several threads, see Value::parallel
+#ifdef CXXOPTS_USE_THREADS
+#include <thread>
+#endif
+
+// For platforms without threads: drops the locking that lets several threads
+// call Options::help at once
+#ifdef CXXOPTS_NO_THREADS
+#  ifdef CXXOPTS_USE_THREADS
+#    error "CXXOPTS_NO_THREADS and CXXOPTS_USE_THREADS cannot both be defined"
 #  endif
+#else
+#include <atomic>
+#include <mutex>
 #endif
+
 #if defined(_MSC_VER) && !defined(__clang__)
 #define CXXOPTS_LINKONCE_CONST	__declspec(selectany) extern
 #define CXXOPTS_LINKONCE		__declspec(selectany) extern
@@ -61,10 +71,6 @@ THE SOFTWARE.
 #define CXXOPTS_LINKONCE
 #endif
 
-#ifndef CXXOPTS_NO_REGEX
-#  include <regex>
-#endif  // CXXOPTS_NO_REGEX
-
 // Nonstandard before C++17, which is coincidentally what we also need for <optional>
 #ifdef __has_include
 #  if __has_include(<optional>)
@@ -79,6 +85,23 @@ THE SOFTWARE.
 #      define CXXOPTS_HAS_FILESYSTEM
 #    endif
 #  endif
+#  if __has_include(<charconv>)
+#    include <charconv>
+#    ifdef __cpp_lib_to_chars
+#      define CXXOPTS_HAS_FROM_CHARS
+#    endif
+#  endif
+#  if __has_include(<memory_resource>)
+#    include <memory_resource>
+#    ifdef __cpp_lib_memory_resource
+#      define CXXOPTS_HAS_MEMORY_RESOURCE
+#    endif
+#  endif
+#endif
+
+// Floating point parsing falls back to a stream in the classic locale
+#ifndef CXXOPTS_HAS_FROM_CHARS
+#include <locale>
 #endif
 
 #define CXXOPTS_FALLTHROUGH
@@ -95,6 +118,19 @@ THE SOFTWARE.
 #define CXXOPTS_NODISCARD
 #endif
 
+// Option names can be checked by consteval functions, see _names
+#if defined(__cpp_consteval) && __cpp_consteval >= 201811L
+#define CXXOPTS_HAS_CONSTEVAL
+#endif
+
+// Help descriptions are scanned for whitespace 16 bytes at a time with SSE2,
+// define CXXOPTS_NO_SIMD to always use the plain loop
+#if !defined(CXXOPTS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) \
+  || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CXXOPTS_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifndef CXXOPTS_VECTOR_DELIMITER
 #define CXXOPTS_VECTOR_DELIMITER ','
 #endif
@@ -135,6 +171,161 @@ static constexpr struct {
 };
 } // namespace cxxopts
 
+namespace cxxopts {
+namespace detail {
+
+// Help text is laid out in terminal columns. Descriptions are UTF-8, and the
+// width of each code point is looked up in the tables below, which hold the
+// combining marks of the common scripts and the East Asian wide and
+// fullwidth ranges.
+
+struct CodepointRange
+{
+  std::uint32_t first;
+  std::uint32_t last;
+};
+
+template <std::size_t N>
+bool
+in_ranges(const CodepointRange (&ranges)[N], std::uint32_t cp)
+{
+  const auto range = std::upper_bound(ranges, ranges + N, cp,
+    [](std::uint32_t c, const CodepointRange& r) { return c < r.first; });
+  return range != ranges && cp <= (range - 1)->last;
+}
+
+inline
+std::size_t
+codepoint_width(std::uint32_t cp)
+{
+  static constexpr CodepointRange zero_width[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0900, 0x0902}, {0x093A, 0x093A},
+    {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957},
+    {0x0962, 0x0963}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E},
+    {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+    {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20F0}, {0x302A, 0x302D},
+    {0x3099, 0x309A}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+    {0xE0001, 0xE0001}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF},
+  };
+  static constexpr CodepointRange wide[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x3029},
+    {0x302E, 0x303E}, {0x3041, 0x3098}, {0x309B, 0xA4CF}, {0xA960, 0xA97F},
+    {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF},
+    {0x1AFF0, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F202},
+    {0x1F210, 0x1F23B}, {0x1F240, 0x1F248}, {0x1F250, 0x1F251},
+    {0x1F260, 0x1F265}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF},
+    {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+  };
+
+  if (cp < 0x0300)
+  {
+    return 1;
+  }
+  if (in_ranges(zero_width, cp))
+  {
+    return 0;
+  }
+  return in_ranges(wide, cp) ? 2 : 1;
+}
+
+// Decodes the code point at first and sets next past it. A byte that does not
+// start a valid sequence decodes on its own, as itself.
+inline
+std::uint32_t
+utf8_decode(const char* first, const char* last, const char*& next)
+{
+  const auto lead = static_cast<unsigned char>(*first);
+  next = first + 1;
+
+  std::ptrdiff_t length = 0;
+  std::uint32_t cp = 0;
+  unsigned char low = 0x80;
+  unsigned char high = 0xBF;
+
+  if (lead >= 0xC2 && lead <= 0xDF)
+  {
+    length = 2;
+    cp = lead & 0x1Fu;
+  }
+  else if (lead >= 0xE0 && lead <= 0xEF)
+  {
+    length = 3;
+    cp = lead & 0x0Fu;
+    low = lead == 0xE0 ? 0xA0 : 0x80;
+    high = lead == 0xED ? 0x9F : 0xBF;
+  }
+  else if (lead >= 0xF0 && lead <= 0xF4)
+  {
+    length = 4;
+    cp = lead & 0x07u;
+    low = lead == 0xF0 ? 0x90 : 0x80;
+    high = lead == 0xF4 ? 0x8F : 0xBF;
+  }
+  else
+  {
+    return lead;
+  }
+
+  if (last - first < length)
+  {
+    return lead;
+  }
+
+  for (std::ptrdiff_t i = 1; i != length; ++i)
+  {
+    const auto byte = static_cast<unsigned char>(first[i]);
+    if (byte < low || byte > high)
+    {
+      return lead;
+    }
+    low = 0x80;
+    high = 0xBF;
+    cp = (cp << 6) | (byte & 0x3Fu);
+  }
+
+  next = first + length;
+  return cp;
+}
+
+// The number of terminal columns taken by the UTF-8 text [first, last)
+inline
+std::size_t
+display_width(const char* first, const char* last)
+{
+  std::size_t width = 0;
+  while (first != last)
+  {
+    if (static_cast<unsigned char>(*first) < 0x80)
+    {
+      ++width;
+      ++first;
+    }
+    else
+    {
+      width += codepoint_width(utf8_decode(first, last, first));
+    }
+  }
+
+  return width;
+}
+
+} // namespace detail
+} // namespace cxxopts
+
 //when we ask cxxopts to use Unicode, help strings are processed using ICU,
 //which results in the correct lengths being computed for strings when they
 //are formatted for the help output
@@ -176,10 +367,25 @@ class UnicodeStringIterator
   {
   }
 
+  // The UTF-16 unit at this position, so that copying the units of a range
+  // copies surrogate pairs once
   value_type
   operator*() const
   {
-    return s->char32At(i);
+    return s->charAt(i);
+  }
+
+  // The columns the unit at this position adds to a line: those of its code
+  // point, or none for the second half of a surrogate pair
+  std::size_t
+  width() const
+  {
+    if ((s->charAt(i) & 0xFC00) == 0xDC00 && i > 0 &&
+        (s->charAt(i - 1) & 0xFC00) == 0xD800)
+    {
+      return 0;
+    }
+    return detail::codepoint_width(static_cast<std::uint32_t>(s->char32At(i)));
   }
 
   bool
@@ -245,11 +451,18 @@ stringAppend(String& s, Iterator begin, Iterator end)
   return s;
 }
 
+// The width of s in terminal columns
 inline
 size_t
 stringLength(const String& s)
 {
-  return static_cast<size_t>(s.length());
+  std::size_t width = 0;
+  for (int32_t i = 0; i < s.length(); i = s.moveIndex32(i, 1))
+  {
+    width += detail::codepoint_width(static_cast<std::uint32_t>(s.char32At(i)));
+  }
+
+  return width;
 }
 
 inline
@@ -303,11 +516,12 @@ toLocalString(T&& t)
   return std::forward<T>(t);
 }
 
+// The width of the UTF-8 text s in terminal columns
 inline
 std::size_t
 stringLength(const String& s)
 {
-  return s.length();
+  return detail::display_width(s.data(), s.data() + s.size());
 }
 
 inline
@@ -386,6 +600,20 @@ class Value : public std::enable_shared_from_this<Value>
   std::shared_ptr<Value>
   clone() const = 0;
 
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  // Like clone, but allocates the copy and the T it stores from `resource`.
+  // Whatever the T allocates itself, such as the characters of a string,
+  // still comes from the global heap. Values that do not override this are
+  // cloned normally.
+  virtual
+  std::shared_ptr<Value>
+  clone(std::pmr::memory_resource* resource) const
+  {
+    static_cast<void>(resource);
+    return clone();
+  }
+#endif
+
   virtual void
   add(const std::string& text) const = 0;
 
@@ -395,6 +623,21 @@ class Value : public std::enable_shared_from_this<Value>
   virtual void
   parse() const = 0;
 
+  // Restores storage owned by the value to a default constructed state, so
+  // that it can be reused by a later parse. External storage is left alone.
+  // Values that keep no storage of their own have nothing to restore.
+  virtual void
+  reset() const
+  {
+  }
+
+  // True when parsed values are written to a variable given to value(T&)
+  virtual bool
+  has_external_storage() const
+  {
+    return false;
+  }
+
   virtual bool
   has_default() const = 0;
 
@@ -422,6 +665,26 @@ class Value : public std::enable_shared_from_this<Value>
   virtual std::shared_ptr<Value>
   no_implicit_value() = 0;
 
+  // Sets how the elements of a list are separated. An element enclosed in
+  // `quote` may contain the separator. Ignored by values that are not lists.
+  virtual std::shared_ptr<Value>
+  delimiter(char separator, char quote = '\0')
+  {
+    static_cast<void>(separator);
+    static_cast<void>(quote);
+    return shared_from_this();
+  }
+
+  // Converts the elements of large lists on up to `threads` threads, or one
+  // per hardware thread when 0. Only has an effect when CXXOPTS_USE_THREADS
+  // is defined.
+  virtual std::shared_ptr<Value>
+  parallel(unsigned threads = 0)
+  {
+    static_cast<void>(threads);
+    return shared_from_this();
+  }
+
   virtual bool
   is_boolean() const = 0;
 };
@@ -486,6 +749,26 @@ class invalid_option_format : public specification
   }
 };
 
+class option_handle_type_mismatch : public specification
+{
+  public:
+  explicit option_handle_type_mismatch(const std::string& option)
+  : specification("Option " + LQUOTE + option + RQUOTE +
+                  " does not hold the type of its handle")
+  {
+  }
+};
+
+class foreign_option_handle : public exception
+{
+  public:
+  explicit foreign_option_handle(const std::string& index)
+  : exception("Handle of option " + index +
+              " does not belong to the options that were parsed")
+  {
+  }
+};
+
 class invalid_option_syntax : public parsing {
   public:
   explicit invalid_option_syntax(const std::string& text)
@@ -611,293 +894,443 @@ void throw_or_mimic(const std::string& text)
 
 using OptionNames = std::vector<std::string>;
 
-namespace values {
-
-namespace parser_tool {
-
-struct IntegerDesc
+// Characters owned by something else, such as the string pool that keeps the
+// names and description of an option.
+class StringView
 {
-  std::string negative = "";
-  std::string base     = "";
-  std::string value    = "";
-};
-struct ArguDesc {
-  std::string arg_name  = "";
-  bool        grouping  = false;
-  bool        set_value = false;
-  std::string value     = "";
-};
+  public:
+  StringView() = default;
 
-#ifdef CXXOPTS_NO_REGEX
-inline IntegerDesc SplitInteger(const std::string &text)
-{
-  if (text.empty())
+  StringView(const char* data, std::size_t size) noexcept
+  : m_data(data)
+  , m_size(size)
   {
-    throw_or_mimic<exceptions::incorrect_argument_type>(text);
   }
-  IntegerDesc desc;
-  const char *pdata = text.c_str();
-  if (*pdata == '-')
+
+  StringView(const char* text) noexcept
+  : StringView(text, std::strlen(text))
   {
-    pdata += 1;
-    desc.negative = "-";
   }
-  if (strncmp(pdata, "0x", 2) == 0)
+
+  StringView(const std::string& text) noexcept
+  : StringView(text.data(), text.size())
   {
-    pdata += 2;
-    desc.base = "0x";
   }
-  if (*pdata != '\0')
+
+  operator std::string() const
   {
-    desc.value = std::string(pdata);
+    return std::string(m_data, m_size);
   }
-  else
+
+  const char*
+  data() const noexcept
   {
-    throw_or_mimic<exceptions::incorrect_argument_type>(text);
+    return m_data;
   }
-  return desc;
-}
 
-inline bool IsTrueText(const std::string &text)
-{
-  const char *pdata = text.c_str();
-  if (*pdata == 't' || *pdata == 'T')
+  std::size_t
+  size() const noexcept
   {
-    pdata += 1;
-    if (strncmp(pdata, "rue\0", 4) == 0)
-    {
-      return true;
-    }
+    return m_size;
   }
-  else if (strncmp(pdata, "1\0", 2) == 0)
+
+  bool
+  empty() const noexcept
   {
-    return true;
+    return m_size == 0;
   }
-  return false;
-}
 
-inline bool IsFalseText(const std::string &text)
-{
-  const char *pdata = text.c_str();
-  if (*pdata == 'f' || *pdata == 'F')
+  const char*
+  begin() const noexcept
   {
-    pdata += 1;
-    if (strncmp(pdata, "alse\0", 5) == 0)
-    {
-      return true;
-    }
+    return m_data;
   }
-  else if (strncmp(pdata, "0\0", 2) == 0)
+
+  const char*
+  end() const noexcept
   {
-    return true;
+    return m_data + m_size;
   }
-  return false;
-}
 
-static inline bool valid_option_later_char(char c)
+  private:
+  const char* m_data = "";
+  std::size_t m_size = 0;
+};
+
+inline
+bool
+operator==(StringView lhs, StringView rhs) noexcept
 {
-  return c!='=' && c!=',' && !std::isspace(c, std::locale::classic()) && !std::iscntrl(c, std::locale::classic());
+  return lhs.size() == rhs.size() &&
+    std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
 }
 
-static inline bool valid_option_first_char(char c)
+inline
+bool
+operator!=(StringView lhs, StringView rhs) noexcept
 {
-  return c != '-' && valid_option_later_char(c);
+  return !(lhs == rhs);
 }
 
-inline OptionNames split_option_names(const std::string &text)
+inline
+std::ostream&
+operator<<(std::ostream& out, StringView text)
 {
-  OptionNames split_names;
+  return out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
 
-  std::string::size_type token_start_pos = 0;
-  auto length = text.length();
+namespace detail {
 
-  if (length == 0)
-  {
-    throw_or_mimic<exceptions::invalid_option_format>(text);
-  }
+// An arena for the names and descriptions of a set of options, so that they
+// are stored together in a few blocks instead of one or more blocks each.
+// Strings are only ever added, and never move once they are.
+class StringPool
+{
+  public:
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
 
-  while (token_start_pos < length) {
-    const auto &npos = std::string::npos;
-    auto next_non_space_pos = text.find_first_not_of(' ', token_start_pos);
-    if (next_non_space_pos == npos) {
-      throw_or_mimic<exceptions::invalid_option_format>(text);
+  StringView
+  add(StringView text)
+  {
+    const auto size = text.size();
+    if (size == 0)
+    {
+      return StringView();
     }
-    token_start_pos = next_non_space_pos;
-    auto next_delimiter_pos = text.find(',', token_start_pos);
 
-    if (next_delimiter_pos == npos) {
-      next_delimiter_pos = length;
-    }
-    else if (next_delimiter_pos == token_start_pos) {
-      throw_or_mimic<exceptions::invalid_option_format>(text);
-    }
-    else if(next_delimiter_pos == length-1) {
-      // delimter at the end. ex : "a,ab,"
-      throw_or_mimic<exceptions::invalid_option_format>(text);
-    }
-    auto token_length = next_delimiter_pos - token_start_pos;
+    if (size > m_left)
     {
-      if(!valid_option_first_char(text[token_start_pos])){
-        throw_or_mimic<exceptions::invalid_option_format>(text);
-      }
-      for(size_t i=token_start_pos+1; i<next_delimiter_pos; ++i){
-        if(!valid_option_later_char(text[i])) {
-          throw_or_mimic<exceptions::invalid_option_format>(text);
-        }
+      // A long string gets a block to itself, and the current one is kept
+      if (size >= m_block_size / 2)
+      {
+        m_blocks.emplace_back(new char[size]);
+        std::memcpy(m_blocks.back().get(), text.data(), size);
+        return StringView(m_blocks.back().get(), size);
       }
+
+      m_blocks.emplace_back(new char[m_block_size]);
+      m_next = m_blocks.back().get();
+      m_left = m_block_size;
+      m_block_size = (std::min)(m_block_size * 2, std::size_t{16384});
     }
-    split_names.emplace_back(text.substr(token_start_pos, token_length));
-    token_start_pos = next_delimiter_pos + 1;
+
+    std::memcpy(m_next, text.data(), size);
+    StringView result(m_next, size);
+    m_next += size;
+    m_left -= size;
+    return result;
   }
-  return split_names;
-}
 
-inline ArguDesc ParseArgument(const char *arg, bool &matched)
+  private:
+  std::vector<std::unique_ptr<char[]>> m_blocks{};
+  char* m_next = nullptr;
+  std::size_t m_left = 0;
+  std::size_t m_block_size = 256;
+};
+
+} // namespace detail
+
+// The long names of an option. Most options have one or two, which are kept
+// inline, and the names of an option with more are kept on the heap.
+class NameList
 {
-  ArguDesc argu_desc;
-  const char *pdata = arg;
-  matched = false;
-  if (strncmp(pdata, "--", 2) == 0)
+  public:
+  NameList() = default;
+
+  // Copies the names from first to last, which are anything a StringView
+  // can be made from, into `strings`
+  template <typename Iterator>
+  NameList(Iterator first, Iterator last, detail::StringPool& strings)
+  : m_size(static_cast<std::size_t>(std::distance(first, last)))
   {
-    pdata += 2;
-    if (valid_option_first_char(*pdata))
+    auto out = m_inline;
+    if (m_size > inline_count)
     {
-      argu_desc.arg_name.push_back(*pdata);
-      pdata += 1;
-      while (valid_option_later_char(*pdata))
-      {
-        argu_desc.arg_name.push_back(*pdata);
-        pdata += 1;
-      }
-      if (argu_desc.arg_name.length() > 1)
-      {
-        if (*pdata == '=')
-        {
-          argu_desc.set_value = true;
-          pdata += 1;
-          if (*pdata != '\0')
-          {
-            argu_desc.value = std::string(pdata);
-          }
-          matched = true;
-        }
-        else if (*pdata == '\0')
-        {
-          matched = true;
-        }
-      }
+      m_more.reset(new StringView[m_size]);
+      out = m_more.get();
+    }
+    for (; first != last; ++first)
+    {
+      *out++ = strings.add(*first);
     }
   }
-  else if (strncmp(pdata, "-", 1) == 0)
+
+  NameList(const OptionNames& names, detail::StringPool& strings)
+  : NameList(names.begin(), names.end(), strings)
   {
-    pdata += 1;
-    if(valid_option_first_char(*pdata)) {
-      // If we have '=' right after first alnum, its a match.
-      if(*(pdata+1) == '=') {
-        argu_desc.arg_name.push_back(*pdata);
-        argu_desc.set_value = true;
-        argu_desc.value = std::string(pdata+2);
-      }
-      else{
-        argu_desc.arg_name = std::string(pdata);
-      }
-      argu_desc.grouping = true;
-      matched = true;
-    }
   }
-  return argu_desc;
-}
 
-#else  // CXXOPTS_NO_REGEX
+  NameList(const NameList& rhs)
+  : m_size(rhs.m_size)
+  {
+    auto out = m_inline;
+    if (m_size > inline_count)
+    {
+      m_more.reset(new StringView[m_size]);
+      out = m_more.get();
+    }
+    std::copy(rhs.begin(), rhs.end(), out);
+  }
 
-namespace {
+  NameList(NameList&& rhs) noexcept
+  : m_more(std::move(rhs.m_more))
+  , m_size(rhs.m_size)
+  {
+    std::copy(rhs.m_inline, rhs.m_inline + inline_count, m_inline);
+    rhs.m_size = 0;
+  }
 
-#define CXXOPTS_RE_NAME_START "[^-=,[:space:][:cntrl:]]"
-#define CXXOPTS_RE_NAME_CHAR "[^=,[:space:][:cntrl:]]"
-#define CXXOPTS_RE_NAME CXXOPTS_RE_NAME_START CXXOPTS_RE_NAME_CHAR "*"
-#define CXXOPTS_RE_LONG_NAME CXXOPTS_RE_NAME_START CXXOPTS_RE_NAME_CHAR "+"
-#define CXXOPTS_RE_SHORT_NAME CXXOPTS_RE_NAME_START
-
-CXXOPTS_LINKONCE
-const char* const integer_pattern =
-  "(-)?(0x)?([0-9a-zA-Z]+)|((0x)?0)";
-CXXOPTS_LINKONCE
-const char* const truthy_pattern =
-  "(t|T)(rue)?|1";
-CXXOPTS_LINKONCE
-const char* const falsy_pattern =
-  "(f|F)(alse)?|0";
-CXXOPTS_LINKONCE
-const char* const option_pattern =
-  "--(" CXXOPTS_RE_LONG_NAME ")(=(.*))?|-(" CXXOPTS_RE_SHORT_NAME ")((=(.*))|(.*))";
-// <-------Long Option--------------->  <-------------Short Option--------------->
-// Groups :
-//   <---------1--------------><--2-->   <-----------4-------------><-----5------>
-//                               <-3>                                <--6--> <-8>
-//                                                                         <-7>
-const int LONG_NAME_IDX=1;
-const int LONG_MATCH_IDX=2;
-const int LONG_MATCH_VALUE_IDX=3;
-const int SHORT_NAME_IDX=4;
-const int SHORT_MATCH_IDX=6;
-const int SHORT_MATCH_VALUE_IDX=7;
-const int SHORT_GROUPING_IDX=8;
-
-CXXOPTS_LINKONCE
-const char* const option_specifier_pattern =
-  "(" CXXOPTS_RE_NAME ")(,[ ]*" CXXOPTS_RE_NAME ")*";
-CXXOPTS_LINKONCE
-const char* const option_specifier_separator_pattern = ", *";
-
-#undef CXXOPTS_RE_NAME_START
-#undef CXXOPTS_RE_NAME_CHAR
-#undef CXXOPTS_RE_NAME
-#undef CXXOPTS_RE_LONG_NAME
-#undef CXXOPTS_RE_SHORT_NAME
+  NameList&
+  operator=(const NameList& rhs)
+  {
+    NameList copy(rhs);
+    return *this = std::move(copy);
+  }
 
-} // namespace
+  NameList&
+  operator=(NameList&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      std::copy(rhs.m_inline, rhs.m_inline + inline_count, m_inline);
+      m_more = std::move(rhs.m_more);
+      m_size = rhs.m_size;
+      rhs.m_size = 0;
+    }
+    return *this;
+  }
 
-inline IntegerDesc SplitInteger(const std::string &text)
-{
-  static const std::basic_regex<char> integer_matcher(integer_pattern);
+  std::size_t
+  size() const noexcept
+  {
+    return m_size;
+  }
 
-  std::smatch match;
-  std::regex_match(text, match, integer_matcher);
+  bool
+  empty() const noexcept
+  {
+    return m_size == 0;
+  }
 
-  if (match.length() == 0)
+  const StringView*
+  begin() const noexcept
   {
-    throw_or_mimic<exceptions::incorrect_argument_type>(text);
+    return m_size > inline_count ? m_more.get() : m_inline;
   }
 
-  IntegerDesc desc;
-  desc.negative = match[1];
-  desc.base = match[2];
-  desc.value = match[3];
+  const StringView*
+  end() const noexcept
+  {
+    return begin() + m_size;
+  }
 
-  if (match.length(4) > 0)
+  StringView
+  front() const noexcept
   {
-    desc.base = match[5];
-    desc.value = "0";
-    return desc;
+    return *begin();
   }
 
-  return desc;
+  StringView
+  operator[](std::size_t i) const noexcept
+  {
+    return begin()[i];
+  }
+
+  private:
+  static constexpr std::size_t inline_count = 2;
+
+  StringView m_inline[inline_count]{};
+  std::unique_ptr<StringView[]> m_more{};
+  std::size_t m_size = 0;
+};
+
+
+namespace values {
+
+namespace parser_tool {
+
+struct ArguDesc {
+  std::string arg_name  = "";
+  bool        grouping  = false;
+  bool        set_value = false;
+  std::string value     = "";
+};
+
+// The result of scanning a single command line argument. The name and value
+// point into the scanned argument, so scanning never copies or allocates.
+struct ArguScan
+{
+  const char* name        = nullptr;
+  std::size_t name_length = 0;
+  bool        grouping    = false;
+  bool        set_value   = false;
+  // Only meaningful when set_value is true, runs to the end of the argument.
+  const char* value       = nullptr;
+};
+
+// The value of a hexadecimal digit in either case, or 16 if `ch` is not one
+inline unsigned
+digit_value(char ch)
+{
+  if (ch >= '0' && ch <= '9')
+  {
+    return static_cast<unsigned>(ch - '0');
+  }
+
+  const char lower = static_cast<char>(ch | 0x20);
+  if (lower >= 'a' && lower <= 'f')
+  {
+    return static_cast<unsigned>(lower - 'a' + 10);
+  }
+  return 16;
+}
+
+// Accumulates the digits in [first, last) into `result`. Digits may be
+// separated by single underscores, as in 1_000_000. Fails if a character is
+// not a digit of the base or the value would exceed `limit`.
+template <unsigned Base, typename U>
+bool
+accumulate_digits(const char* first, const char* last, U limit, U& result)
+{
+  const U cutoff = static_cast<U>(limit / Base);
+  const unsigned cutlim = static_cast<unsigned>(limit % Base);
+
+  result = 0;
+  bool after_digit = false;
+  for (const char* p = first; p != last; ++p)
+  {
+    if (*p == '_' && after_digit && p + 1 != last)
+    {
+      after_digit = false;
+      continue;
+    }
+
+    // Characters below '0' wrap around to large values
+    const unsigned digit = Base <= 10
+      ? static_cast<unsigned>(*p - '0')
+      : digit_value(*p);
+    if (digit >= Base || result > cutoff || (result == cutoff && digit > cutlim))
+    {
+      return false;
+    }
+    result = static_cast<U>(result * Base + digit);
+    after_digit = true;
+  }
+
+  return after_digit;
+}
+
+inline char
+ascii_lower(char c)
+{
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Reads a boolean written as true/false, t/f, yes/no, on/off or 1/0 in any
+// case.
+// Returns false if the text is none of these.
+inline bool
+parse_bool_text(const char* text, std::size_t length, bool& value)
+{
+  struct BoolText
+  {
+    const char* text;
+    std::size_t length;
+    bool value;
+  };
+
+  static const BoolText table[] = {
+    {"true", 4, true}, {"false", 5, false},
+    {"t", 1, true}, {"f", 1, false},
+    {"yes", 3, true}, {"no", 2, false},
+    {"on", 2, true}, {"off", 3, false},
+    {"1", 1, true}, {"0", 1, false},
+  };
+
+  for (const auto& entry : table)
+  {
+    if (entry.length != length)
+    {
+      continue;
+    }
+
+    std::size_t i = 0;
+    while (i != length && ascii_lower(text[i]) == entry.text[i])
+    {
+      ++i;
+    }
+
+    if (i == length)
+    {
+      value = entry.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Option names may contain anything except '=', ',', whitespace and control
+// characters, and may not start with '-'. This is deliberately independent of
+// the global locale.
+constexpr bool is_space_or_control(char c)
+{
+  return static_cast<unsigned char>(c) <= 0x20 ||
+    static_cast<unsigned char>(c) == 0x7f;
+}
+
+constexpr bool valid_option_later_char(char c)
+{
+  return c != '=' && c != ',' && !is_space_or_control(c);
 }
 
-inline bool IsTrueText(const std::string &text)
+constexpr bool valid_option_first_char(char c)
 {
-  static const std::basic_regex<char> truthy_matcher(truthy_pattern);
-  std::smatch result;
-  std::regex_match(text, result, truthy_matcher);
-  return !result.empty();
+  return c != '-' && valid_option_later_char(c);
 }
 
-inline bool IsFalseText(const std::string &text)
+// Calls f(first, last) for each of the option names specified via a single,
+// comma-separated string, which are space-discarded and non-empty (without
+// considering which or how many are single-character)
+template <typename F>
+void
+for_each_option_name(const std::string& text, F f)
 {
-  static const std::basic_regex<char> falsy_matcher(falsy_pattern);
-  std::smatch result;
-  std::regex_match(text, result, falsy_matcher);
-  return !result.empty();
+  const char* current = text.data();
+  const char* const end = current + text.size();
+
+  while (true)
+  {
+    if (current == end || !valid_option_first_char(*current))
+    {
+      throw_or_mimic<exceptions::invalid_option_format>(text);
+    }
+
+    const char* name_start = current;
+    ++current;
+    while (current != end && valid_option_later_char(*current))
+    {
+      ++current;
+    }
+    f(name_start, current);
+
+    if (current == end)
+    {
+      break;
+    }
+
+    // Names are separated by a comma, optionally followed by spaces
+    if (*current != ',')
+    {
+      throw_or_mimic<exceptions::invalid_option_format>(text);
+    }
+    ++current;
+    while (current != end && *current == ' ')
+    {
+      ++current;
+    }
+  }
 }
 
 // Gets the option names specified via a single, comma-separated string,
@@ -905,101 +1338,244 @@ inline bool IsFalseText(const std::string &text)
 // (without considering which or how many are single-character)
 inline OptionNames split_option_names(const std::string &text)
 {
-  static const std::basic_regex<char> option_specifier_matcher(option_specifier_pattern);
-  if (!std::regex_match(text.c_str(), option_specifier_matcher))
+  OptionNames split_names;
+  for_each_option_name(text, [&](const char* first, const char* last) {
+    split_names.emplace_back(first, last);
+  });
+  return split_names;
+}
+
+// The names of an option split into its short name and its long names, as
+// views of the text they were given in. The long names are kept inline
+// unless there are more than a few, so splitting usually allocates nothing.
+class SplitNames
+{
+  public:
+  explicit SplitNames(const std::string& text)
+  {
+    bool has_short = false;
+    for_each_option_name(text, [&](const char* first, const char* last) {
+      const StringView name(first, static_cast<std::size_t>(last - first));
+      if (name.size() == 1)
+      {
+        if (has_short)
+        {
+          throw_or_mimic<exceptions::invalid_option_format>(text);
+        }
+        has_short = true;
+        m_short = name;
+      }
+      else if (m_size < inline_count)
+      {
+        m_inline[m_size++] = name;
+      }
+      else
+      {
+        if (m_more.empty())
+        {
+          m_more.assign(m_inline, m_inline + inline_count);
+        }
+        m_more.push_back(name);
+        ++m_size;
+      }
+    });
+  }
+
+  StringView
+  short_name() const noexcept
   {
-    throw_or_mimic<exceptions::invalid_option_format>(text);
+    return m_short;
   }
 
-  OptionNames split_names;
+  const StringView*
+  begin() const noexcept
+  {
+    return m_size > inline_count ? m_more.data() : m_inline;
+  }
 
-  static const std::basic_regex<char> option_specifier_separator_matcher(option_specifier_separator_pattern);
-  constexpr int use_non_matches { -1 };
-  auto token_iterator = std::sregex_token_iterator(
-    text.begin(), text.end(), option_specifier_separator_matcher, use_non_matches);
-  std::copy(token_iterator, std::sregex_token_iterator(), std::back_inserter(split_names));
-  return split_names;
+  const StringView*
+  end() const noexcept
+  {
+    return begin() + m_size;
+  }
+
+  private:
+  static constexpr std::size_t inline_count = 4;
+
+  StringView m_short{};
+  StringView m_inline[inline_count]{};
+  std::vector<StringView> m_more{};
+  std::size_t m_size = 0;
+};
+
+// The same rules as split_option_names, for the constexpr OptionSpec. Each
+// name is found by its offset into the spec.
+
+// Length of the name starting at `name`, which has a valid first character
+constexpr std::size_t spec_name_length(const char* name, std::size_t length = 1)
+{
+  return valid_option_later_char(name[length])
+    ? spec_name_length(name, length + 1)
+    : length;
 }
 
-inline ArguDesc ParseArgument(const char *arg, bool &matched)
+constexpr std::size_t spec_skip_spaces(const char* spec, std::size_t offset)
 {
-  static const std::basic_regex<char> option_matcher(option_pattern);
-  std::match_results<const char*> result;
-  std::regex_match(arg, result, option_matcher);
-  matched = !result.empty();
+  return spec[offset] == ' ' ? spec_skip_spaces(spec, offset + 1) : offset;
+}
 
-  ArguDesc argu_desc;
-  if (matched) {
-    if(result[LONG_NAME_IDX].length() > 0) {
-      argu_desc.arg_name = result[LONG_NAME_IDX].str();
-      argu_desc.set_value = result[LONG_MATCH_IDX].length() > 0;
-      argu_desc.value = result[LONG_MATCH_VALUE_IDX].str();
-    }
-    else if (result[SHORT_NAME_IDX].length() > 0)
-    {
-      argu_desc.grouping = true;
-      argu_desc.arg_name = result[SHORT_NAME_IDX].str();
-      if(result[SHORT_MATCH_IDX].length() > 0){
-        argu_desc.set_value = true;
-        argu_desc.value = result[SHORT_MATCH_VALUE_IDX].str();
-      } else {
-        argu_desc.arg_name += result[SHORT_GROUPING_IDX].str();
-      }
-    }
-  }
+// The offset of the name after the one at `offset`, past the comma
+constexpr std::size_t spec_next_name(const char* spec, std::size_t offset)
+{
+  return spec_skip_spaces(spec, offset + spec_name_length(spec + offset) + 1);
+}
 
-  return argu_desc;
+constexpr bool spec_valid(const char* spec, std::size_t offset = 0)
+{
+  return valid_option_first_char(spec[offset]) &&
+    (spec[offset + spec_name_length(spec + offset)] == '\0' ||
+      (spec[offset + spec_name_length(spec + offset)] == ',' &&
+        spec_valid(spec, spec_next_name(spec, offset))));
 }
 
-#endif  // CXXOPTS_NO_REGEX
-#undef CXXOPTS_NO_REGEX
-} // namespace parser_tool
+// The remaining functions expect a spec that is valid
+constexpr std::size_t spec_name_count(const char* spec, std::size_t offset = 0)
+{
+  return spec[offset + spec_name_length(spec + offset)] == '\0'
+    ? 1
+    : 1 + spec_name_count(spec, spec_next_name(spec, offset));
+}
 
-namespace detail {
+constexpr std::size_t spec_name_offset(const char* spec, std::size_t index,
+  std::size_t offset = 0)
+{
+  return index == 0
+    ? offset
+    : spec_name_offset(spec, index - 1, spec_next_name(spec, offset));
+}
 
-template <typename T, bool B>
-struct SignedCheck;
+constexpr std::size_t spec_short_count(const char* spec, std::size_t offset = 0)
+{
+  return (spec_name_length(spec + offset) == 1 ? 1 : 0) +
+    (spec[offset + spec_name_length(spec + offset)] == '\0'
+      ? 0
+      : spec_short_count(spec, spec_next_name(spec, offset)));
+}
 
-template <typename T>
-struct SignedCheck<T, true>
+// Whether text has a line break, which the value of an option may not
+// contain, as with the regular expressions this scanner replaced
+inline bool has_line_break(const char* text)
 {
-  template <typename U>
-  void
-  operator()(bool negative, U u, const std::string& text)
+  for (; *text != '\0'; ++text)
   {
-    if (negative)
+    if (*text == '\n' || *text == '\r')
     {
-      if (u > static_cast<U>((std::numeric_limits<T>::min)()))
-      {
-        throw_or_mimic<exceptions::incorrect_argument_type>(text);
-      }
+      return true;
     }
-    else
+  }
+  return false;
+}
+
+// Scans a single argument, which matches one of
+//   --name        a long option, where the name is at least two characters
+//   --name=value  a long option with a value
+//   -n=value      a short option with a value
+//   -abc          a group of short options, where the group may also be an
+//                 option followed by its value
+// Values and groups may not contain a line break. Every character is visited
+// at most twice and nothing is allocated, so the cost is linear in the
+// length of the argument.
+inline bool scan_argument(const char* arg, ArguScan& scan)
+{
+  scan = ArguScan();
+
+  if (arg[0] != '-')
+  {
+    return false;
+  }
+
+  if (arg[1] == '-')
+  {
+    const char* name = arg + 2;
+    if (!valid_option_first_char(*name))
+    {
+      return false;
+    }
+
+    const char* name_end = name + 1;
+    while (valid_option_later_char(*name_end))
+    {
+      ++name_end;
+    }
+
+    if (name_end - name < 2)
+    {
+      return false;
+    }
+
+    if (*name_end == '=')
     {
-      if (u > static_cast<U>((std::numeric_limits<T>::max)()))
+      if (has_line_break(name_end + 1))
       {
-        throw_or_mimic<exceptions::incorrect_argument_type>(text);
+        return false;
       }
+      scan.set_value = true;
+      scan.value = name_end + 1;
+    }
+    else if (*name_end != '\0')
+    {
+      return false;
     }
+
+    scan.name = name;
+    scan.name_length = static_cast<std::size_t>(name_end - name);
+    return true;
   }
-};
 
-template <typename T>
-struct SignedCheck<T, false>
-{
-  template <typename U>
-  void
-  operator()(bool, U, const std::string&) const {}
-};
+  const char* name = arg + 1;
+  if (!valid_option_first_char(*name) || has_line_break(name + 1))
+  {
+    return false;
+  }
 
-template <typename T, typename U>
-void
-check_signed_range(bool negative, U value, const std::string& text)
-{
-  SignedCheck<T, std::numeric_limits<T>::is_signed>()(negative, value, text);
+  scan.name = name;
+  scan.grouping = true;
+
+  // If we have '=' right after the first character, it's a value for it
+  if (name[1] == '=')
+  {
+    scan.name_length = 1;
+    scan.set_value = true;
+    scan.value = name + 2;
+  }
+  else
+  {
+    scan.name_length = std::strlen(name);
+  }
+
+  return true;
 }
 
-} // namespace detail
+inline ArguDesc ParseArgument(const char *arg, bool &matched)
+{
+  ArguScan scan;
+  matched = scan_argument(arg, scan);
+
+  ArguDesc argu_desc;
+  if (matched)
+  {
+    argu_desc.arg_name.assign(scan.name, scan.name_length);
+    argu_desc.grouping = scan.grouping;
+    argu_desc.set_value = scan.set_value;
+    if (scan.set_value)
+    {
+      argu_desc.value.assign(scan.value);
+    }
+  }
+
+  return argu_desc;
+}
+} // namespace parser_tool
 
 template <typename R, typename T>
 void
@@ -1018,69 +1594,67 @@ checked_negate(R&, T&&, const std::string& text, std::false_type)
   throw_or_mimic<exceptions::incorrect_argument_type>(text);
 }
 
+// Parses an integer in a single pass without allocating. The text is an
+// optional '-', an optional 0x, 0o or 0b prefix for base 16, 8 or 2, and
+// digits that may be separated by underscores.
 template <typename T>
 void
-integer_parser(const std::string& text, T& value)
+integer_parser(const char* text, std::size_t length, T& value)
 {
-  parser_tool::IntegerDesc int_desc = parser_tool::SplitInteger(text);
-
   using US = typename std::make_unsigned<T>::type;
   constexpr bool is_signed = std::numeric_limits<T>::is_signed;
 
-  const bool          negative    = int_desc.negative.length() > 0;
-  const uint8_t       base        = int_desc.base.length() > 0 ? 16 : 10;
-  const std::string & value_match = int_desc.value;
-
-  US result = 0;
+  const char* first = text;
+  const char* last = text + length;
 
-  for (char ch : value_match)
+  const bool negative = first != last && *first == '-';
+  if (negative)
   {
-    US digit = 0;
-
-    if (ch >= '0' && ch <= '9')
-    {
-      digit = static_cast<US>(ch - '0');
-    }
-    else if (base == 16 && ch >= 'a' && ch <= 'f')
-    {
-      digit = static_cast<US>(ch - 'a' + 10);
-    }
-    else if (base == 16 && ch >= 'A' && ch <= 'F')
-    {
-      digit = static_cast<US>(ch - 'A' + 10);
-    }
-    else
-    {
-      throw_or_mimic<exceptions::incorrect_argument_type>(text);
-    }
+    ++first;
+  }
 
-    US limit = 0;
-    if (negative)
+  unsigned base = 10;
+  if (last - first >= 2 && first[0] == '0')
+  {
+    switch (first[1])
     {
-      limit = static_cast<US>(std::abs(static_cast<intmax_t>((std::numeric_limits<T>::min)())));
+      case 'x': base = 16; break;
+      case 'o': base = 8; break;
+      case 'b': base = 2; break;
+      default: break;
     }
-    else
+    if (base != 10)
     {
-      limit = (std::numeric_limits<T>::max)();
+      first += 2;
     }
+  }
 
-    if (base != 0 && result > limit / base)
-    {
-      throw_or_mimic<exceptions::incorrect_argument_type>(text);
-    }
-    if (result * base > limit - digit)
-    {
-      throw_or_mimic<exceptions::incorrect_argument_type>(text);
-    }
+  // The magnitude of the minimum of a signed type is one more than its
+  // maximum.
+  const auto max = static_cast<US>((std::numeric_limits<T>::max)());
+  const US limit = negative ? static_cast<US>(max + 1) : max;
 
-    result = static_cast<US>(result * base + digit);
+  US result = 0;
+  bool valid = false;
+  switch (base)
+  {
+    // a bare 0x has no digits and is 0, a bare 0o or 0b is an error
+    case 16: valid = first == last || parser_tool::accumulate_digits<16>(first, last, limit, result); break;
+    case 8: valid = parser_tool::accumulate_digits<8>(first, last, limit, result); break;
+    case 2: valid = parser_tool::accumulate_digits<2>(first, last, limit, result); break;
+    default: valid = parser_tool::accumulate_digits<10>(first, last, limit, result); break;
   }
 
-  detail::check_signed_range<T>(negative, result, text);
+  if (!valid || (negative && !is_signed))
+  {
+    throw_or_mimic<exceptions::incorrect_argument_type>(std::string(text, length));
+  }
 
   if (negative)
   {
-    checked_negate<T>(value, result, text, std::integral_constant<bool, is_signed>());
+    // the text is only needed to report negating an unsigned type
+    checked_negate<T>(value, result, std::string(),
+      std::integral_constant<bool, is_signed>());
   }
   else
   {
@@ -1088,6 +1662,13 @@ integer_parser(const std::string& text, T& value)
   }
 }
 
+template <typename T>
+void
+integer_parser(const std::string& text, T& value)
+{
+  integer_parser(text.data(), text.size(), value);
+}
+
 template <typename T>
 void stringstream_parser(const std::string& text, T& value)
 {
@@ -1110,19 +1691,10 @@ inline
 void
 parse_value(const std::string& text, bool& value)
 {
-  if (parser_tool::IsTrueText(text))
-  {
-    value = true;
-    return;
-  }
-
-  if (parser_tool::IsFalseText(text))
+  if (!parser_tool::parse_bool_text(text.data(), text.size(), value))
   {
-    value = false;
-    return;
+    throw_or_mimic<exceptions::incorrect_argument_type>(text);
   }
-
-  throw_or_mimic<exceptions::incorrect_argument_type>(text);
 }
 
 inline
@@ -1132,7 +1704,64 @@ parse_value(const std::string& text, std::string& value)
   value = text;
 }
 
-// The fallback parser. It uses the stringstream parser to parse all types
+// Parses a floating point number the same way in every locale. The whole
+// text must be the number, with no surrounding space.
+template <typename T>
+void
+float_parser(const std::string& text, T& value)
+{
+  const char* first = text.data();
+  const char* last = first + text.size();
+
+  // accepted by operator>> but not by from_chars
+  if (first != last && *first == '+')
+  {
+    ++first;
+    if (first != last && *first == '-')
+    {
+      throw_or_mimic<exceptions::incorrect_argument_type>(text);
+    }
+  }
+
+#ifdef CXXOPTS_HAS_FROM_CHARS
+  const auto result = std::from_chars(first, last, value);
+  if (result.ec != std::errc() || result.ptr != last)
+  {
+    throw_or_mimic<exceptions::incorrect_argument_type>(text);
+  }
+#else
+  std::istringstream in(std::string(first, last));
+  in.imbue(std::locale::classic());
+  in >> std::noskipws >> value;
+  if (!in || in.peek() != std::char_traits<char>::eof())
+  {
+    throw_or_mimic<exceptions::incorrect_argument_type>(text);
+  }
+#endif
+}
+
+inline
+void
+parse_value(const std::string& text, float& value)
+{
+  float_parser(text, value);
+}
+
+inline
+void
+parse_value(const std::string& text, double& value)
+{
+  float_parser(text, value);
+}
+
+inline
+void
+parse_value(const std::string& text, long double& value)
+{
+  float_parser(text, value);
+}
+
+// The fallback parser. It uses the stringstream parser to parse all types
 // that have not been overloaded explicitly.  It has to be placed in the
 // source code before all other more specialized templates.
 template <typename T,
@@ -1174,20 +1803,237 @@ void parse_value(const std::string& text, char& c)
   c = text[0];
 }
 
+template<typename T> void add_value(const std::string& text, T& value);
 template<typename T> void add_value(const std::string& text, std::vector<T>& value);
 
+// How the elements of a list value are written, set with Value::delimiter
+struct ListFormat
+{
+  ListFormat() = default;
+
+  ListFormat(char separator_, char quote_)
+  : separator(separator_)
+  , quote(quote_)
+  {
+  }
+
+  char separator = CXXOPTS_VECTOR_DELIMITER;
+  // No quoting when '\0'
+  char quote = '\0';
+  // Threads to convert large lists with, 0 for one per hardware thread
+  unsigned threads = 1;
+};
+
+// Values other than lists ignore the format
 template <typename T>
 void
-parse_value(const std::string& text, std::vector<T>& value)
+parse_value(const std::string& text, T& value, const ListFormat&)
+{
+  parse_value(text, value);
+}
+
+// Appends the list element [first, last). `token` is a buffer reused for
+// every element, since parse_value takes a string.
+template <typename T>
+void
+add_list_element(const char* first, const char* last, std::string& token, std::vector<T>& value)
+{
+  token.assign(first, last);
+  add_value(token, value);
+}
+
+inline
+void
+add_list_element(const char* first, const char* last, std::string&, std::vector<std::string>& value)
+{
+  value.emplace_back(first, last);
+}
+
+// Calls `f` with the bounds of each element of a list, without quotes
+template <typename F>
+void
+for_each_list_element(const std::string& text, const ListFormat& format, F&& f)
+{
+  const char* first = text.data();
+  const char* const last = first + text.size();
+
+  while (first != last)
+  {
+    const char* end = nullptr;
+    if (format.quote != '\0' && *first == format.quote)
+    {
+      const auto* close = static_cast<const char*>(
+        std::memchr(first + 1, format.quote, static_cast<std::size_t>(last - first - 1)));
+      end = close == nullptr ? nullptr : close + 1;
+      if (end == nullptr || (end != last && *end != format.separator))
+      {
+        throw_or_mimic<exceptions::incorrect_argument_type>(text);
+      }
+      f(first + 1, close);
+    }
+    else
+    {
+      end = static_cast<const char*>(
+        std::memchr(first, format.separator, static_cast<std::size_t>(last - first)));
+      end = end == nullptr ? last : end;
+      f(first, end);
+    }
+
+    // a trailing separator does not start another element
+    if (end == last)
+    {
+      break;
+    }
+    first = end + 1;
+  }
+}
+
+#ifdef CXXOPTS_USE_THREADS
+// Elements each thread converts at least, below which threads do not pay off
+constexpr std::size_t PARALLEL_LIST_CHUNK = 8192;
+
+// Converts the elements of a large list in contiguous chunks, one chunk per
+// thread, and appends them in order. If any element fails, the error for the
+// first failing element in the list is reported, as it would be when
+// converting serially. Returns false, doing nothing, for lists too small to
+// be worth it.
+template <typename T>
+bool
+parse_list_in_parallel
+(
+  const std::string& text,
+  std::vector<T>& value,
+  const ListFormat& format,
+  std::size_t estimate
+)
+{
+  std::size_t threads = format.threads != 0
+    ? format.threads
+    : std::thread::hardware_concurrency();
+  threads = (std::min)(threads, estimate / PARALLEL_LIST_CHUNK);
+  if (threads < 2)
+  {
+    return false;
+  }
+
+  std::vector<std::pair<const char*, const char*>> elements;
+  elements.reserve(estimate);
+  for_each_list_element(text, format, [&elements](const char* first, const char* last) {
+    elements.emplace_back(first, last);
+  });
+
+  const auto base = value.size();
+  value.resize(base + elements.size());
+
+  const auto per_thread = (elements.size() + threads - 1) / threads;
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  std::vector<std::exception_ptr> errors(threads);
+#endif
+  auto convert = [&](std::size_t chunk) {
+    const auto begin = chunk * per_thread;
+    const auto end = (std::min)(elements.size(), begin + per_thread);
+    std::string token;
+#ifndef CXXOPTS_NO_EXCEPTIONS
+    try
+#endif
+    {
+      for (auto i = begin; i < end; ++i)
+      {
+        token.assign(elements[i].first, elements[i].second);
+        add_value(token, value[base + i]);
+      }
+    }
+#ifndef CXXOPTS_NO_EXCEPTIONS
+    catch (...)
+    {
+      errors[chunk] = std::current_exception();
+    }
+#endif
+  };
+
+  // Joins the workers even when starting one of them throws, since a
+  // joinable std::thread terminates the program when it is destroyed.
+  struct Workers
+  {
+    std::vector<std::thread> threads{};
+
+    ~Workers()
+    {
+      for (auto& thread : threads)
+      {
+        if (thread.joinable())
+        {
+          thread.join();
+        }
+      }
+    }
+  } workers;
+
+  for (std::size_t chunk = 1; chunk < threads; ++chunk)
+  {
+    workers.threads.emplace_back(convert, chunk);
+  }
+  convert(0);
+  for (auto& worker : workers.threads)
+  {
+    worker.join();
+  }
+
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  for (const auto& error : errors)
+  {
+    if (error)
+    {
+      value.resize(base);
+      std::rethrow_exception(error);
+    }
+  }
+#endif
+  return true;
+}
+
+// Elements of std::vector<bool> cannot be written from several threads
+inline
+bool
+parse_list_in_parallel(const std::string&, std::vector<bool>&, const ListFormat&, std::size_t)
+{
+  return false;
+}
+#endif
+
+// Splits the text in place, so the only allocations are a single token
+// buffer and the elements themselves.
+template <typename T>
+void
+parse_value(const std::string& text, std::vector<T>& value, const ListFormat& format)
 {
-  if (text.empty()) {
+  if (text.empty())
+  {
     return;
   }
-  std::stringstream in(text);
-  std::string token;
-  while(!in.eof() && std::getline(in, token, CXXOPTS_VECTOR_DELIMITER)) {
-    add_value(token, value);
+
+  const auto estimate =
+    static_cast<std::size_t>(std::count(text.begin(), text.end(), format.separator)) + 1;
+
+#ifdef CXXOPTS_USE_THREADS
+  if (format.threads != 1 && parse_list_in_parallel(text, value, format, estimate))
+  {
+    return;
   }
+#endif
+
+  value.reserve(value.size() + estimate);
+  std::string token;
+  for_each_list_element(text, format, [&](const char* first, const char* last) {
+    add_list_element(first, last, token, value);
+  });
+}
+
+template <typename T>
+void
+parse_value(const std::string& text, std::vector<T>& value)
+{
+  parse_value(text, value, ListFormat());
 }
 
 template <typename T>
@@ -1206,6 +2052,29 @@ add_value(const std::string& text, std::vector<T>& value)
   value.emplace_back(std::move(v));
 }
 
+// Puts a value back into its default constructed state. Strings and vectors
+// are cleared instead so that their buffers can be reused by the next parse.
+template <typename T>
+void
+reset_value(T& value)
+{
+  value = T();
+}
+
+inline
+void
+reset_value(std::string& value)
+{
+  value.clear();
+}
+
+template <typename T>
+void
+reset_value(std::vector<T>& value)
+{
+  value.clear();
+}
+
 template <typename T>
 struct type_is_container
 {
@@ -1255,7 +2124,30 @@ class abstract_value : public Value
     m_implicit = rhs.m_implicit;
     m_default_value = rhs.m_default_value;
     m_implicit_value = rhs.m_implicit_value;
+    m_list_format = rhs.m_list_format;
+  }
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  abstract_value(const abstract_value& rhs, std::pmr::memory_resource* resource)
+  {
+    if (rhs.m_result)
+    {
+      m_result = std::allocate_shared<T>(
+        std::pmr::polymorphic_allocator<T>(resource));
+      m_store = m_result.get();
+    }
+    else
+    {
+      m_store = rhs.m_store;
+    }
+
+    m_default = rhs.m_default;
+    m_implicit = rhs.m_implicit;
+    m_default_value = rhs.m_default_value;
+    m_implicit_value = rhs.m_implicit_value;
+    m_list_format = rhs.m_list_format;
   }
+#endif
 
   void
   add(const std::string& text) const override
@@ -1266,7 +2158,7 @@ class abstract_value : public Value
   void
   parse(const std::string& text) const override
   {
-    parse_value(text, *m_store);
+    parse_value(text, *m_store, m_list_format);
   }
 
   bool
@@ -1278,7 +2170,22 @@ class abstract_value : public Value
   void
   parse() const override
   {
-    parse_value(m_default_value, *m_store);
+    parse_value(m_default_value, *m_store, m_list_format);
+  }
+
+  void
+  reset() const override
+  {
+    if (m_result)
+    {
+      reset_value(*m_result);
+    }
+  }
+
+  bool
+  has_external_storage() const override
+  {
+    return m_result == nullptr;
   }
 
   bool
@@ -1323,6 +2230,21 @@ class abstract_value : public Value
     return shared_from_this();
   }
 
+  std::shared_ptr<Value>
+  delimiter(char separator, char quote = '\0') override
+  {
+    m_list_format.separator = separator;
+    m_list_format.quote = quote;
+    return shared_from_this();
+  }
+
+  std::shared_ptr<Value>
+  parallel(unsigned threads = 0) override
+  {
+    m_list_format.threads = threads;
+    return shared_from_this();
+  }
+
   std::string
   get_default_value() const override
   {
@@ -1341,6 +2263,12 @@ class abstract_value : public Value
     return std::is_same<T, bool>::value;
   }
 
+  const ListFormat&
+  list_format() const
+  {
+    return m_list_format;
+  }
+
   const T&
   get() const
   {
@@ -1363,6 +2291,7 @@ class abstract_value : public Value
 
   std::string m_default_value{};
   std::string m_implicit_value{};
+  ListFormat m_list_format{};
 };
 
 template <typename T>
@@ -1377,6 +2306,17 @@ class standard_value : public abstract_value<T>
   {
     return std::make_shared<standard_value<T>>(*this);
   }
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  CXXOPTS_NODISCARD
+  std::shared_ptr<Value>
+  clone(std::pmr::memory_resource* resource) const override
+  {
+    return std::allocate_shared<standard_value<T>>(
+      std::pmr::polymorphic_allocator<standard_value<T>>(resource), *this,
+      resource);
+  }
+#endif
 };
 
 template <>
@@ -1395,12 +2335,29 @@ class standard_value<bool> : public abstract_value<bool>
     m_implicit_value = "true";
   }
 
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  standard_value(const standard_value& rhs, std::pmr::memory_resource* resource)
+  : abstract_value(rhs, resource)
+  {
+  }
+#endif
+
   std::shared_ptr<Value>
   clone() const override
   {
     return std::make_shared<standard_value<bool>>(*this);
   }
 
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  std::shared_ptr<Value>
+  clone(std::pmr::memory_resource* resource) const override
+  {
+    return std::allocate_shared<standard_value<bool>>(
+      std::pmr::polymorphic_allocator<standard_value<bool>>(resource), *this,
+      resource);
+  }
+#endif
+
   private:
 
   void
@@ -1440,39 +2397,85 @@ first_or_empty(const OptionNames& long_names)
   return long_names.empty() ? empty : long_names.front();
 }
 
+CXXOPTS_NODISCARD
+inline
+StringView
+first_or_empty(const NameList& long_names)
+{
+  return long_names.empty() ? StringView() : long_names.front();
+}
+
 class OptionDetails
 {
   public:
+  // The names and description are kept in strings, which Options shares
+  // between all of its options
+  OptionDetails
+  (
+    std::shared_ptr<detail::StringPool> strings,
+    const std::string& short_,
+    const OptionNames& long_,
+    const std::string& desc,
+    std::shared_ptr<const Value> val,
+    std::size_t index = 0
+  )
+  : OptionDetails(std::move(strings), short_, long_.begin(), long_.end(), desc,
+      std::move(val), index)
+  {
+  }
+
+  template <typename Iterator>
   OptionDetails
   (
-    std::string short_,
-    OptionNames long_,
-    String desc,
-    std::shared_ptr<const Value> val
+    std::shared_ptr<detail::StringPool> strings,
+    StringView short_,
+    Iterator long_first,
+    Iterator long_last,
+    StringView desc,
+    std::shared_ptr<const Value> val,
+    std::size_t index
   )
-  : m_short(std::move(short_))
-  , m_long(std::move(long_))
-  , m_desc(std::move(desc))
+  : m_strings(std::move(strings))
+  , m_short(m_strings->add(short_))
+  , m_long(long_first, long_last, *m_strings)
+  , m_desc(m_strings->add(desc))
   , m_value(std::move(val))
   , m_count(0)
+  , m_index(index)
+  {
+  }
+
+  OptionDetails
+  (
+    const std::string& short_,
+    const OptionNames& long_,
+    const String& desc,
+    std::shared_ptr<const Value> val,
+    std::size_t index = 0
+  )
+  : OptionDetails(std::make_shared<detail::StringPool>(), short_, long_,
+      toUTF8String(desc), std::move(val), index)
   {
-    m_hash = std::hash<std::string>{}(first_long_name() + m_short);
   }
 
   OptionDetails(const OptionDetails& rhs)
-  : m_desc(rhs.m_desc)
+  : m_strings(rhs.m_strings)
+  , m_short(rhs.m_short)
+  , m_long(rhs.m_long)
+  , m_desc(rhs.m_desc)
   , m_value(rhs.m_value->clone())
   , m_count(rhs.m_count)
+  , m_index(rhs.m_index)
   {
   }
 
   OptionDetails(OptionDetails&& rhs) = default;
 
   CXXOPTS_NODISCARD
-  const String&
+  String
   description() const
   {
-    return m_desc;
+    return toLocalString(std::string(m_desc));
   }
 
   CXXOPTS_NODISCARD
@@ -1488,48 +2491,60 @@ class OptionDetails
     return m_value->clone();
   }
 
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
   CXXOPTS_NODISCARD
-  const std::string&
+  std::shared_ptr<Value>
+  make_storage(std::pmr::memory_resource* resource) const
+  {
+    return m_value->clone(resource);
+  }
+#endif
+
+  CXXOPTS_NODISCARD
+  StringView
   short_name() const
   {
     return m_short;
   }
 
   CXXOPTS_NODISCARD
-  const std::string&
+  StringView
   first_long_name() const
   {
     return first_or_empty(m_long);
   }
 
   CXXOPTS_NODISCARD
-  const std::string&
+  StringView
   essential_name() const
   {
     return m_long.empty() ? m_short : m_long.front();
   }
 
   CXXOPTS_NODISCARD
-  const OptionNames &
+  const NameList&
   long_names() const
   {
     return m_long;
   }
 
+  // The position of the option in the order it was added, which is used to
+  // store its parsed value.
   std::size_t
-  hash() const
+  index() const
   {
-    return m_hash;
+    return m_index;
   }
 
   private:
-  std::string m_short{};
-  OptionNames m_long{};
-  String m_desc{};
+  std::shared_ptr<detail::StringPool> m_strings{};
+  StringView m_short{};
+  NameList m_long{};
+  StringView m_desc{};
   std::shared_ptr<const Value> m_value{};
   int m_count;
 
-  std::size_t m_hash{};
+  std::size_t m_index;
 };
 
 struct HelpOptionDetails
@@ -1553,658 +2568,2655 @@ struct HelpGroupDetails
   std::vector<HelpOptionDetails> options{};
 };
 
-class OptionValue
+using OptionMap = std::unordered_map<std::string, std::shared_ptr<OptionDetails>>;
+
+namespace detail {
+
+// What Options keeps for the help of an option. The names, description and
+// values are read from the option itself when the help is rendered, only the
+// argument name is not stored anywhere else.
+struct HelpEntry
 {
-  public:
-  void
-  add
-  (
-    const std::shared_ptr<const OptionDetails>& details,
-    const std::string& text
-  )
-  {
-    ensure_value(details);
-    ++m_count;
-    m_value->add(text);
-    m_long_names = &details->long_names();
-  }
+  std::shared_ptr<const OptionDetails> option;
+  StringView arg_help;
+};
 
-  void
-  parse
-  (
-    const std::shared_ptr<const OptionDetails>& details,
-    const std::string& text
-  )
-  {
-    ensure_value(details);
-    ++m_count;
-    m_value->parse(text);
-    m_long_names = &details->long_names();
-  }
+inline
+HelpOptionDetails
+help_details(const HelpEntry& entry)
+{
+  const auto& option = *entry.option;
+  const auto& value = option.value();
+  return HelpOptionDetails{option.short_name(),
+    OptionNames(option.long_names().begin(), option.long_names().end()),
+    option.description(),
+    value.has_default(), value.get_default_value(),
+    value.has_implicit(), value.get_implicit_value(),
+    entry.arg_help,
+    value.is_container(),
+    value.is_boolean()};
+}
 
-  void
-  parse_default(const std::shared_ptr<const OptionDetails>& details)
+// 64 bit FNV-1a
+inline
+std::uint64_t
+hash_name(const char* name, std::size_t length)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for (std::size_t i = 0; i != length; ++i)
   {
-    ensure_value(details);
-    m_default = true;
-    m_long_names = &details->long_names();
-    m_value->parse();
+    hash ^= static_cast<unsigned char>(name[i]);
+    hash *= 1099511628211ull;
   }
+  return hash;
+}
 
-  void
-  parse_no_value(const std::shared_ptr<const OptionDetails>& details)
-  {
-    m_long_names = &details->long_names();
-  }
+// Picks a slot for a name hash, given the displacement of its bucket
+inline
+std::uint64_t
+displace_hash(std::uint64_t hash, std::uint64_t displacement)
+{
+  hash ^= displacement * 0x9e3779b97f4a7c15ull;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  return hash;
+}
 
-#if defined(CXXOPTS_NULL_DEREF_IGNORE)
-CXXOPTS_DIAGNOSTIC_PUSH
-CXXOPTS_IGNORE_WARNING("-Wnull-dereference")
-#endif
+// The entry a name hash may belong to plus one, or 0 when it belongs to none,
+// in a table laid out by PerfectHash
+inline
+std::uint32_t
+perfect_hash_slot
+(
+  const std::uint32_t* displacements,
+  std::uint64_t bucket_mask,
+  const std::uint32_t* slots,
+  std::uint64_t slot_mask,
+  std::uint64_t hash
+)
+{
+  return slots[displace_hash(hash, displacements[hash & bucket_mask]) & slot_mask];
+}
 
-  CXXOPTS_NODISCARD
-  std::size_t
-  count() const noexcept
+// A collision free (perfect) hash of a fixed set of names, given the
+// hash_name of each. Every name gets a slot of its own, so a lookup only has
+// to compare the one name in its slot.
+class PerfectHash
+{
+  public:
+  // Returns false, leaving the table empty, when no table could be found,
+  // which is always the case when two of the hashes are equal
+  bool
+  build(const std::vector<std::uint64_t>& hashes);
+
+  // The index in `hashes` of the name that may have `hash` plus one, or 0
+  std::uint32_t
+  find(std::uint64_t hash) const
   {
-    return m_count;
+    return m_slots.empty()
+      ? 0
+      : perfect_hash_slot(m_displacements.data(), m_bucket_mask,
+          m_slots.data(), m_slot_mask, hash);
   }
 
-#if defined(CXXOPTS_NULL_DEREF_IGNORE)
-CXXOPTS_DIAGNOSTIC_POP
-#endif
+  // The layout of the table, for writing it out as source code
+  const std::vector<std::uint32_t>& displacements() const { return m_displacements; }
+  const std::vector<std::uint32_t>& slots() const { return m_slots; }
+  std::uint64_t bucket_mask() const { return m_bucket_mask; }
+  std::uint64_t slot_mask() const { return m_slot_mask; }
 
-  // TODO: maybe default options should count towards the number of arguments
-  CXXOPTS_NODISCARD
+  private:
   bool
-  has_default() const noexcept
+  place(const std::vector<std::uint64_t>& hashes, std::size_t slot_count);
+
+  // One displacement per bucket, and one entry index plus one per slot.
+  std::vector<std::uint32_t> m_displacements{};
+  std::vector<std::uint32_t> m_slots{};
+  std::uint64_t m_bucket_mask = 0;
+  std::uint64_t m_slot_mask = 0;
+};
+
+// hash_name for names known at compile time
+constexpr
+std::uint64_t
+hash_literal(const char* name, std::size_t length,
+  std::uint64_t hash = 14695981039346656037ull)
+{
+  return length == 0
+    ? hash
+    : hash_literal(name + 1, length - 1,
+        (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull);
+}
+
+constexpr
+std::size_t
+literal_length(const char* name, std::size_t length = 0)
+{
+  return name[length] == '\0' ? length : literal_length(name, length + 1);
+}
+
+constexpr
+bool
+literal_equal(const char* a, const char* b)
+{
+  return *a == *b && (*a == '\0' || literal_equal(a + 1, b + 1));
+}
+
+} // namespace detail
+
+// An option name hashed at compile time, made with the _opt literal or by
+// an OptionSchema. Looking it up in a result skips hashing the name.
+class OptionKey
+{
+  public:
+  constexpr OptionKey(const char* name, std::size_t length)
+  : m_name(name)
+  , m_length(length)
+  , m_hash(detail::hash_literal(name, length))
   {
-    return m_default;
   }
 
-  template <typename T>
-  const T&
-  as() const
+  constexpr
+  const char*
+  name() const
   {
-    if (m_value == nullptr) {
-        throw_or_mimic<exceptions::option_has_no_value>(
-            m_long_names == nullptr ? "" : first_or_empty(*m_long_names));
-    }
-
-    return CXXOPTS_RTTI_CAST<const values::standard_value<T>&>(*m_value).get();
+    return m_name;
   }
 
-#ifdef CXXOPTS_HAS_OPTIONAL
-  template <typename T>
-  std::optional<T>
-  as_optional() const
+  constexpr
+  std::size_t
+  length() const
   {
-    if (m_value == nullptr) {
-      return std::nullopt;
-    }
-    return as<T>();
+    return m_length;
   }
-#endif
 
-  private:
-  void
-  ensure_value(const std::shared_ptr<const OptionDetails>& details)
+  constexpr
+  std::uint64_t
+  hash() const
   {
-    if (m_value == nullptr)
-    {
-      m_value = details->make_storage();
-    }
+    return m_hash;
   }
 
-
-  const OptionNames * m_long_names = nullptr;
-  // Holding this pointer is safe, since OptionValue's only exist in key-value pairs,
-  // where the key has the string we point to.
-  std::shared_ptr<Value> m_value{};
-  std::size_t m_count = 0;
-  bool m_default = false;
+  private:
+  const char* m_name;
+  std::size_t m_length;
+  std::uint64_t m_hash;
 };
 
-class KeyValue
+namespace literals {
+
+constexpr
+OptionKey
+operator""_opt(const char* name, std::size_t length)
+{
+  return OptionKey(name, length);
+}
+
+} // namespace literals
+
+namespace detail {
+
+// Deliberately not constexpr, so that asking an OptionSchema for a name it
+// does not declare fails to compile in a constant expression.
+inline
+OptionKey
+option_not_in_schema(const char* name)
+{
+  throw_or_mimic<exceptions::no_such_option>(name);
+  return OptionKey(name, literal_length(name));
+}
+
+} // namespace detail
+
+// The option names a program declares, for checking keys at compile time:
+//
+//   constexpr const char* names[] = {"threads", "name"};
+//   constexpr cxxopts::OptionSchema schema(names);
+//   constexpr auto threads = schema.key("threads");
+//
+// A name missing from the schema makes the last line fail to compile. Pass
+// the schema to Options::add_schema to have every name in it checked
+// against the options that are actually added.
+class OptionSchema
 {
   public:
-  KeyValue(std::string key_, std::string value_) noexcept
-  : m_key(std::move(key_))
-  , m_value(std::move(value_))
+  template <std::size_t N>
+  constexpr explicit OptionSchema(const char* const (&names)[N])
+  : m_names(names)
+  , m_size(N)
   {
   }
 
-  CXXOPTS_NODISCARD
-  const std::string&
-  key() const
+  constexpr
+  std::size_t
+  size() const
   {
-    return m_key;
+    return m_size;
   }
 
-  CXXOPTS_NODISCARD
-  const std::string&
-  value() const
+  constexpr
+  const char*
+  name(std::size_t i) const
   {
-    return m_value;
+    return m_names[i];
   }
 
-  template <typename T>
-  T
-  as() const
+  constexpr
+  bool
+  contains(const char* name, std::size_t i = 0) const
   {
-    T result;
-    values::parse_value(m_value, result);
-    return result;
+    return i != m_size &&
+      (detail::literal_equal(m_names[i], name) || contains(name, i + 1));
+  }
+
+  constexpr
+  OptionKey
+  key(const char* name) const
+  {
+    return contains(name)
+      ? OptionKey(name, detail::literal_length(name))
+      : detail::option_not_in_schema(name);
   }
 
   private:
-  std::string m_key;
-  std::string m_value;
+  const char* const* m_names;
+  std::size_t m_size;
 };
 
-using ParsedHashMap = std::unordered_map<std::size_t, OptionValue>;
-using NameHashMap = std::unordered_map<std::string, std::size_t>;
+namespace detail {
 
-class ParseResult
+// Deliberately not constexpr, so that a constexpr OptionSpec with invalid
+// names fails to compile.
+inline
+const char*
+invalid_option_spec(const char* spec)
+{
+  throw_or_mimic<exceptions::invalid_option_format>(spec);
+  return spec;
+}
+
+} // namespace detail
+
+// An option that can be declared constexpr, so that a table of options is
+// built at compile time:
+//
+//   constexpr cxxopts::OptionSpec specs[] = {
+//     {"t,threads", "Thread count", &cxxopts::value<int>, "4"},
+//     {"v,verbose", "Verbose output"},
+//   };
+//   options.add_options("", specs);
+//
+// The names are split and checked when the spec is constructed. A spec with
+// invalid names, more than one short name or more than MAX_NAMES names fails
+// to compile when it is constexpr, and throws invalid_option_format when it
+// is not.
+class OptionSpec
 {
   public:
-  class Iterator
+  using MakeValue = std::shared_ptr<Value> (*)();
+
+  static constexpr std::size_t MAX_NAMES = 4;
+
+  // The position and length of a name in the spec
+  struct Name
   {
-    public:
-    using iterator_category = std::forward_iterator_tag;
-    using value_type = KeyValue;
-    using difference_type = void;
-    using pointer = const KeyValue*;
-    using reference = const KeyValue&;
+    std::size_t offset;
+    std::size_t length;
+  };
 
-    Iterator() = default;
-    Iterator(const Iterator&) = default;
+  constexpr OptionSpec
+  (
+    const char* opts,
+    const char* desc,
+    MakeValue factory = &::cxxopts::value<bool>,
+    const char* default_value = nullptr,
+    const char* implicit_value = nullptr,
+    const char* arg_help = ""
+  )
+  : m_opts(checked(opts))
+  , m_desc(desc)
+  , m_make_value(factory)
+  , m_default_value(default_value)
+  , m_implicit_value(implicit_value)
+  , m_arg_help(arg_help)
+  , m_name_count(values::parser_tool::spec_name_count(opts))
+  , m_names{name(opts, 0), name(opts, 1), name(opts, 2), name(opts, 3)}
+  {
+  }
 
-// GCC complains about m_iter not being initialised in the member
-// initializer list
-CXXOPTS_DIAGNOSTIC_PUSH
-CXXOPTS_IGNORE_WARNING("-Weffc++")
-    Iterator(const ParseResult *pr, bool end=false)
-    : m_pr(pr)
+  constexpr const char* opts() const { return m_opts; }
+  constexpr const char* desc() const { return m_desc; }
+  constexpr MakeValue make_value() const { return m_make_value; }
+  constexpr const char* default_value() const { return m_default_value; }
+  constexpr const char* implicit_value() const { return m_implicit_value; }
+  constexpr const char* arg_help() const { return m_arg_help; }
+
+  constexpr
+  std::size_t
+  name_count() const
+  {
+    return m_name_count;
+  }
+
+  // The names in the order they were given, short and long
+  constexpr
+  Name
+  name(std::size_t index) const
+  {
+    return m_names[index];
+  }
+
+  // Copies out the short name, or an empty string, and the long names
+  void
+  split_names(std::string& short_name, OptionNames& long_names) const
+  {
+    long_names.reserve(m_name_count);
+    for (std::size_t i = 0; i != m_name_count; ++i)
     {
-      if (end)
+      if (m_names[i].length == 1)
       {
-        m_sequential = false;
-        m_iter = m_pr->m_defaults.end();
+        short_name.assign(m_opts + m_names[i].offset, 1);
       }
       else
       {
-        m_sequential = true;
-        m_iter = m_pr->m_sequential.begin();
-
-        if (m_iter == m_pr->m_sequential.end())
-        {
-          m_sequential = false;
-          m_iter = m_pr->m_defaults.begin();
-        }
+        long_names.emplace_back(m_opts + m_names[i].offset, m_names[i].length);
       }
     }
-CXXOPTS_DIAGNOSTIC_POP
+  }
 
-    Iterator& operator++()
+  // Views of the short name, or an empty view, and the long names, which are
+  // written to `long_names`. Returns the number of long names.
+  std::size_t
+  split_names(StringView& short_name, StringView (&long_names)[MAX_NAMES]) const
+  {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != m_name_count; ++i)
     {
-      ++m_iter;
-      if(m_sequential && m_iter == m_pr->m_sequential.end())
+      const StringView name(m_opts + m_names[i].offset, m_names[i].length);
+      if (name.size() == 1)
       {
-        m_sequential = false;
-        m_iter = m_pr->m_defaults.begin();
-        return *this;
+        short_name = name;
+      }
+      else
+      {
+        long_names[count++] = name;
       }
-      return *this;
     }
+    return count;
+  }
 
-    Iterator operator++(int)
-    {
-      Iterator retval = *this;
-      ++(*this);
-      return retval;
-    }
+  private:
+  static
+  constexpr
+  const char*
+  checked(const char* opts)
+  {
+    return values::parser_tool::spec_valid(opts) &&
+        values::parser_tool::spec_name_count(opts) <= MAX_NAMES &&
+        values::parser_tool::spec_short_count(opts) <= 1
+      ? opts
+      : detail::invalid_option_spec(opts);
+  }
+
+  static
+  constexpr
+  Name
+  name(const char* opts, std::size_t index)
+  {
+    return index < values::parser_tool::spec_name_count(opts)
+      ? Name{values::parser_tool::spec_name_offset(opts, index),
+          values::parser_tool::spec_name_length(
+            opts + values::parser_tool::spec_name_offset(opts, index))}
+      : Name{0, 0};
+  }
+
+  const char* m_opts;
+  const char* m_desc;
+  MakeValue m_make_value;
+  const char* m_default_value;
+  const char* m_implicit_value;
+  const char* m_arg_help;
+  std::size_t m_name_count;
+  Name m_names[MAX_NAMES];
+};
 
-    bool operator==(const Iterator& other) const
-    {
-      return (m_sequential == other.m_sequential) && (m_iter == other.m_iter);
-    }
+#ifdef CXXOPTS_HAS_CONSTEVAL
+namespace detail {
 
-    bool operator!=(const Iterator& other) const
+constexpr
+bool
+same_name(const OptionSpec& a, std::size_t i, const OptionSpec& b, std::size_t j)
+{
+  const auto x = a.name(i);
+  const auto y = b.name(j);
+  if (x.length != y.length)
+  {
+    return false;
+  }
+  for (std::size_t k = 0; k != x.length; ++k)
+  {
+    if (a.opts()[x.offset + k] != b.opts()[y.offset + k])
     {
-      return !(*this == other);
+      return false;
     }
+  }
+  return true;
+}
 
-    const KeyValue& operator*()
+constexpr
+bool
+unique_names(const OptionSpec* first, const OptionSpec* last)
+{
+  for (auto a = first; a != last; ++a)
+  {
+    for (std::size_t i = 0; i != a->name_count(); ++i)
     {
-      return *m_iter;
-    }
+      for (auto b = a; b != last; ++b)
+      {
+        for (std::size_t j = b == a ? i + 1 : 0; j < b->name_count(); ++j)
+        {
+          if (same_name(*a, i, *b, j))
+          {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
 
-    const KeyValue* operator->()
+// Deliberately not constexpr, see invalid_option_spec
+inline
+void
+duplicate_option_name(const char* spec)
+{
+  throw_or_mimic<exceptions::option_already_exists>(spec);
+}
+
+} // namespace detail
+
+// Option names split and checked at compile time, made with the _names
+// literal. Adding an option with these does not scan the names at run time,
+// and malformed or repeated names are compile errors:
+//
+//   options.add_options()("a,apple,ringo"_names, "An apple");
+class OptionNamesLiteral
+{
+  public:
+  consteval explicit OptionNamesLiteral(const char* opts)
+  : m_spec(opts, "")
+  {
+    if (!detail::unique_names(&m_spec, &m_spec + 1))
     {
-      return m_iter.operator->();
+      detail::duplicate_option_name(opts);
     }
+  }
 
-    private:
-    const ParseResult* m_pr;
-    std::vector<KeyValue>::const_iterator m_iter;
-    bool m_sequential = true;
-  };
+  constexpr
+  const OptionSpec&
+  spec() const
+  {
+    return m_spec;
+  }
 
-  ParseResult() = default;
-  ParseResult(const ParseResult&) = default;
+  private:
+  OptionSpec m_spec;
+};
 
-  ParseResult(NameHashMap&& keys, ParsedHashMap&& values, std::vector<KeyValue> sequential,
-          std::vector<KeyValue> default_opts, std::vector<std::string>&& unmatched_args)
-  : m_keys(std::move(keys))
-  , m_values(std::move(values))
-  , m_sequential(std::move(sequential))
-  , m_defaults(std::move(default_opts))
-  , m_unmatched(std::move(unmatched_args))
+namespace literals {
+
+consteval
+OptionNamesLiteral
+operator""_names(const char* opts, std::size_t)
+{
+  return OptionNamesLiteral(opts);
+}
+
+} // namespace literals
+
+// Whether no name is used twice in a table of OptionSpec, for checking the
+// table with static_assert
+template <std::size_t N>
+consteval
+bool
+unique_names(const OptionSpec (&specs)[N])
+{
+  return detail::unique_names(specs, specs + N);
+}
+#endif
+
+// A read-only table from every short and long name to its option. The names
+// live in one contiguous buffer and are placed with a collision free (perfect)
+// hash, so a lookup costs one hash of the name and one memcmp.
+class OptionIndex
+{
+  public:
+  OptionIndex() = default;
+
+  // `schema` is the detail::next_schema_id of the Options it is built for
+  explicit OptionIndex(const OptionMap& options, std::uint64_t schema = 0);
+
+  const std::shared_ptr<OptionDetails>*
+  find(const char* name, std::size_t length) const
   {
+    return find(name, length, detail::hash_name(name, length));
   }
 
-  ParseResult& operator=(ParseResult&&) = default;
-  ParseResult& operator=(const ParseResult&) = default;
-
-  Iterator
-  begin() const
+  const std::shared_ptr<OptionDetails>*
+  find(const std::string& name) const
   {
-    return Iterator(this);
+    return find(name.data(), name.size());
   }
 
-  Iterator
-  end() const
+  const std::shared_ptr<OptionDetails>*
+  find(const OptionKey& key) const
   {
-    return Iterator(this, true);
+    return find(key.name(), key.length(), key.hash());
   }
 
-  std::size_t
-  count(const std::string& o) const
+  // `hash` must be detail::hash_name of the name
+  const std::shared_ptr<OptionDetails>*
+  find(const char* name, std::size_t length, std::uint64_t hash) const
   {
-    auto iter = m_keys.find(o);
-    if (iter == m_keys.end())
+    if (!m_by_hash.empty())
     {
-      return 0;
+      return find_colliding(name, length, hash);
     }
 
-    auto viter = m_values.find(iter->second);
-
-    if (viter == m_values.end())
+    const auto slot = m_hash.find(hash);
+    if (slot == 0)
     {
-      return 0;
+      return nullptr;
     }
 
-    return viter->second.count();
+    const auto& entry = m_entries[slot - 1];
+    return matches(entry, name, length) ? &entry.details : nullptr;
   }
 
-  bool
-  contains(const std::string& o) const
+  std::size_t
+  size() const
   {
-    return static_cast<bool>(count(o));
+    return m_entries.size();
   }
 
-  const OptionValue&
-  operator[](const std::string& option) const
+  // Every option once, ordered by OptionDetails::index
+  const std::vector<std::shared_ptr<OptionDetails>>&
+  options() const
   {
-    auto iter = m_keys.find(option);
-
-    if (iter == m_keys.end())
-    {
-      throw_or_mimic<exceptions::requested_option_not_present>(option);
-    }
+    return m_options;
+  }
 
-    auto viter = m_values.find(iter->second);
+  std::uint64_t
+  schema() const
+  {
+    return m_schema;
+  }
 
-    if (viter == m_values.end())
-    {
-      throw_or_mimic<exceptions::requested_option_not_present>(option);
-    }
+  private:
+  struct Entry
+  {
+    std::size_t offset;
+    std::size_t length;
+    std::shared_ptr<OptionDetails> details;
+  };
 
-    return viter->second;
+  bool
+  matches(const Entry& entry, const char* name, std::size_t length) const
+  {
+    return entry.length == length &&
+      std::memcmp(m_names.data() + entry.offset, name, length) == 0;
   }
 
-#ifdef CXXOPTS_HAS_OPTIONAL
-  template <typename T>
-  std::optional<T>
-  as_optional(const std::string& option) const
+  const std::shared_ptr<OptionDetails>*
+  find_colliding(const char* name, std::size_t length, std::uint64_t hash) const
   {
-    auto iter = m_keys.find(option);
-    if (iter != m_keys.end())
+    auto candidate = std::lower_bound(m_by_hash.begin(), m_by_hash.end(),
+      std::make_pair(hash, std::size_t{0}));
+    for (; candidate != m_by_hash.end() && candidate->first == hash; ++candidate)
     {
-      auto viter = m_values.find(iter->second);
-      if (viter != m_values.end())
+      const auto& entry = m_entries[candidate->second];
+      if (matches(entry, name, length))
       {
-        return viter->second.as_optional<T>();
+        return &entry.details;
       }
     }
-    return std::nullopt;
+    return nullptr;
   }
-#endif
 
-  const std::vector<KeyValue>&
-  arguments() const
+  std::string m_names{};
+  std::vector<Entry> m_entries{};
+  std::vector<std::shared_ptr<OptionDetails>> m_options{};
+  detail::PerfectHash m_hash{};
+  // Only used when the names could not be perfectly hashed, the hash of
+  // each name and its entry, sorted
+  std::vector<std::pair<std::uint64_t, std::size_t>> m_by_hash{};
+  std::uint64_t m_schema = 0;
+};
+
+class KeyValue
+{
+  public:
+  KeyValue(std::string key_, std::string value_) noexcept
+  : m_key(std::move(key_))
+  , m_value(std::move(value_))
   {
-    return m_sequential;
   }
 
-  const std::vector<std::string>&
-  unmatched() const
+  CXXOPTS_NODISCARD
+  const std::string&
+  key() const
   {
-    return m_unmatched;
+    return m_key;
   }
 
-  const std::vector<KeyValue>&
-  defaults() const
+  CXXOPTS_NODISCARD
+  const std::string&
+  value() const
   {
-    return m_defaults;
+    return m_value;
   }
 
-  const std::string
-  arguments_string() const
+  template <typename T>
+  T
+  as() const
   {
-    std::string result;
-    for(const auto& kv: m_sequential)
-    {
-      result += kv.key() + " = " + kv.value() + "\n";
-    }
-    for(const auto& kv: m_defaults)
-    {
-      result += kv.key() + " = " + kv.value() + " " + "(default)" + "\n";
-    }
+    T result;
+    values::parse_value(m_value, result);
     return result;
   }
 
   private:
-  NameHashMap m_keys{};
-  ParsedHashMap m_values{};
-  std::vector<KeyValue> m_sequential{};
-  std::vector<KeyValue> m_defaults{};
-  std::vector<std::string> m_unmatched{};
-};
+  friend class OptionParser;
 
-struct Option
-{
-  Option
-  (
-    std::string opts,
-    std::string desc,
-    std::shared_ptr<const Value>  value = ::cxxopts::value<bool>(),
-    std::string arg_help = ""
-  )
-  : opts_(std::move(opts))
-  , desc_(std::move(desc))
-  , value_(std::move(value))
-  , arg_help_(std::move(arg_help))
+  // Overwrites both strings, reusing their allocations
+  void
+  assign(StringView key_, const char* value_)
   {
+    m_key.assign(key_.data(), key_.size());
+    m_value.assign(value_);
   }
 
-  std::string opts_;
-  std::string desc_;
-  std::shared_ptr<const Value> value_;
-  std::string arg_help_;
+  std::string m_key;
+  std::string m_value;
 };
 
-using OptionMap = std::unordered_map<std::string, std::shared_ptr<OptionDetails>>;
-using PositionalList = std::vector<std::string>;
-using PositionalListIterator = PositionalList::const_iterator;
+namespace detail {
 
-class OptionParser
+#ifdef CXXOPTS_NO_THREADS
+struct Mutex {};
+struct Lock
 {
-  public:
-  OptionParser(const OptionMap& options, const PositionalList& positional, bool allow_unrecognised)
-  : m_options(options)
-  , m_positional(positional)
-  , m_allow_unrecognised(allow_unrecognised)
+  explicit Lock(Mutex&)
   {
   }
-
-  ParseResult
-  parse(int argc, const char* const* argv);
-
-  bool
-  consume_positional(const std::string& a, PositionalListIterator& next);
-
-  void
-  checked_parse_arg
-  (
-    int argc,
-    const char* const* argv,
-    int& current,
-    const std::shared_ptr<OptionDetails>& value,
-    const std::string& name
-  );
-
-  void
-  add_to_option(const std::shared_ptr<OptionDetails>& value, const std::string& arg);
-
-  void
-  parse_option
-  (
-    const std::shared_ptr<OptionDetails>& value,
-    const std::string& name,
-    const std::string& arg = ""
-  );
-
-  void
-  parse_default(const std::shared_ptr<OptionDetails>& details);
-
-  void
-  parse_no_value(const std::shared_ptr<OptionDetails>& details);
-
-  private:
-
-  void finalise_aliases();
-
-  const OptionMap& m_options;
-  const PositionalList& m_positional;
-
-  std::vector<KeyValue> m_sequential{};
-  std::vector<KeyValue> m_defaults{};
-  bool m_allow_unrecognised;
-
-  ParsedHashMap m_parsed{};
-  NameHashMap m_keys{};
 };
+using PendingCount = std::size_t;
+#else
+using Mutex = std::mutex;
+using Lock = std::lock_guard<std::mutex>;
+using PendingCount = std::atomic<std::size_t>;
+#endif
 
-class Options
+// The number of values of a ParseResult still waiting for their deferred
+// conversion, and the lock they are converted under, so that any number of
+// threads may read a result at once. Once nothing is pending, reads take no
+// lock at all.
+class PendingConversions
 {
   public:
+  PendingConversions() = default;
 
-  explicit Options(std::string program_name, std::string help_string = "")
-  : m_program(std::move(program_name))
-  , m_help_string(toLocalString(std::move(help_string)))
-  , m_custom_help("[OPTION...]")
-  , m_positional_help("positional parameters")
-  , m_show_positional(false)
-  , m_allow_unrecognised(false)
-  , m_width(76)
-  , m_tab_expansion(false)
-  , m_options(std::make_shared<OptionMap>())
+  PendingConversions(const PendingConversions& rhs)
+  : m_count(rhs.count())
   {
   }
 
-  Options&
-  positional_help(std::string help_text)
+  PendingConversions&
+  operator=(const PendingConversions& rhs)
   {
-    m_positional_help = std::move(help_text);
+    m_count = rhs.count();
     return *this;
   }
 
-  Options&
-  custom_help(std::string help_text)
+  std::size_t
+  count() const
   {
-    m_custom_help = std::move(help_text);
-    return *this;
+#ifdef CXXOPTS_NO_THREADS
+    return m_count;
+#else
+    return m_count.load(std::memory_order_acquire);
+#endif
   }
 
-  Options&
-  show_positional_help()
+  void
+  set(std::size_t count)
   {
-    m_show_positional = true;
-    return *this;
+    m_count = count;
   }
 
-  Options&
-  allow_unrecognised_options()
+  // Runs convert under the lock, which returns true if it converted a value
+  template <typename Convert>
+  void
+  run(Convert convert)
   {
-    m_allow_unrecognised = true;
-    return *this;
+    Lock lock(m_mutex);
+    if (convert())
+    {
+#ifdef CXXOPTS_NO_THREADS
+      --m_count;
+#else
+      m_count.fetch_sub(1, std::memory_order_release);
+#endif
+    }
   }
 
-  Options&
-  set_width(std::size_t width)
-  {
-    m_width = width;
-    return *this;
-  }
+  private:
+  Mutex m_mutex{};
+  PendingCount m_count{0};
+};
 
-  Options&
-  set_tab_expansion(bool expansion=true)
-  {
+} // namespace detail
+
+class OptionValue
+{
+  public:
+  void
+  add
+  (
+    const std::shared_ptr<const OptionDetails>& details,
+    const std::string& text
+  )
+  {
+    ensure_value(details);
+    ++m_count;
+    m_value->add(text);
+    m_long_names = &details->long_names();
+  }
+
+  void
+  parse
+  (
+    const std::shared_ptr<const OptionDetails>& details,
+    const std::string& text
+  )
+  {
+    ensure_value(details);
+    ++m_count;
+    m_value->parse(text);
+    m_long_names = &details->long_names();
+  }
+
+  void
+  parse_default(const std::shared_ptr<const OptionDetails>& details)
+  {
+    ensure_value(details);
+    m_default = true;
+    m_long_names = &details->long_names();
+    m_value->parse();
+  }
+
+  void
+  parse_no_value(const std::shared_ptr<const OptionDetails>& details)
+  {
+    m_long_names = &details->long_names();
+  }
+
+  // How an occurrence recorded by defer is converted
+  enum class Conversion
+  {
+    Add,
+    Parse,
+    Default,
+  };
+
+  // Counts an occurrence without converting it. `text` is the position of
+  // its argument in the list passed to convert, and is unused for defaults.
+  void
+  defer
+  (
+    const std::shared_ptr<const OptionDetails>& details,
+    Conversion conversion,
+    std::size_t text
+  )
+  {
+    if (conversion == Conversion::Default)
+    {
+      m_default = true;
+    }
+    else
+    {
+      ++m_count;
+    }
+    m_deferred.push_back(Deferred{conversion, text});
+    m_long_names = &details->long_names();
+  }
+
+  CXXOPTS_NODISCARD
+  bool
+  deferred() const noexcept
+  {
+    return !m_deferred.empty();
+  }
+
+  // Converts the deferred occurrences in order. If one fails the value is
+  // left without a value and the next call tries again from the start.
+  void
+  convert
+  (
+    const std::shared_ptr<const OptionDetails>& details,
+    const std::vector<KeyValue>& texts
+  )
+  {
+    m_has_value = false;
+    prepare_storage(details);
+
+    for (const auto& deferred : m_deferred)
+    {
+      switch (deferred.conversion)
+      {
+        case Conversion::Add:
+          m_value->add(texts[deferred.text].value());
+          break;
+        case Conversion::Parse:
+          m_value->parse(texts[deferred.text].value());
+          break;
+        case Conversion::Default:
+          m_value->parse();
+          break;
+      }
+    }
+
+    m_deferred.clear();
+    m_has_value = true;
+  }
+
+  // Forgets the parsed value but keeps its storage, which is reused by the
+  // next parse of the same option.
+  void
+  reset() noexcept
+  {
+    m_count = 0;
+    m_default = false;
+    m_has_value = false;
+    m_deferred.clear();
+  }
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  // As reset, and storage made for later values comes from `resource`, or
+  // the global heap when it is null.
+  void
+  reset(std::pmr::memory_resource* resource) noexcept
+  {
+    reset();
+    m_resource = resource;
+  }
+#endif
+
+#if defined(CXXOPTS_NULL_DEREF_IGNORE)
+CXXOPTS_DIAGNOSTIC_PUSH
+CXXOPTS_IGNORE_WARNING("-Wnull-dereference")
+#endif
+
+  CXXOPTS_NODISCARD
+  std::size_t
+  count() const noexcept
+  {
+    return m_count;
+  }
+
+#if defined(CXXOPTS_NULL_DEREF_IGNORE)
+CXXOPTS_DIAGNOSTIC_POP
+#endif
+
+  // TODO: maybe default options should count towards the number of arguments
+  CXXOPTS_NODISCARD
+  bool
+  has_default() const noexcept
+  {
+    return m_default;
+  }
+
+  template <typename T>
+  const T&
+  as() const
+  {
+    if (!m_has_value) {
+        throw_or_mimic<exceptions::option_has_no_value>(
+            m_long_names == nullptr ? "" : first_or_empty(*m_long_names));
+    }
+
+    return CXXOPTS_RTTI_CAST<const values::standard_value<T>&>(*m_value).get();
+  }
+
+  // As as<T>, without checking that T is the type of the value. Only for
+  // types already checked when the option was added, as for an OptionHandle.
+  template <typename T>
+  const T&
+  as_unchecked() const
+  {
+    if (!m_has_value) {
+        throw_or_mimic<exceptions::option_has_no_value>(
+            m_long_names == nullptr ? "" : first_or_empty(*m_long_names));
+    }
+
+    return static_cast<const values::standard_value<T>&>(*m_value).get();
+  }
+
+#ifdef CXXOPTS_HAS_OPTIONAL
+  template <typename T>
+  std::optional<T>
+  as_optional() const
+  {
+    if (!m_has_value) {
+      return std::nullopt;
+    }
+    return as<T>();
+  }
+#endif
+
+  private:
+  void
+  ensure_value(const std::shared_ptr<const OptionDetails>& details)
+  {
+    if (m_has_value)
+    {
+      return;
+    }
+
+    prepare_storage(details);
+    m_has_value = true;
+  }
+
+  // Storage left from an earlier parse is reused, unless a copy of the
+  // earlier result still refers to it.
+  void
+  prepare_storage(const std::shared_ptr<const OptionDetails>& details)
+  {
+    if (m_value == nullptr || m_value.use_count() != 1)
+    {
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+      m_value = m_resource == nullptr
+        ? details->make_storage()
+        : details->make_storage(m_resource);
+#else
+      m_value = details->make_storage();
+#endif
+    }
+    else
+    {
+      m_value->reset();
+    }
+  }
+
+
+  const NameList * m_long_names = nullptr;
+  // Holding this pointer is safe, since OptionValue's only exist in key-value pairs,
+  // where the key has the string we point to.
+  std::shared_ptr<Value> m_value{};
+  struct Deferred
+  {
+    Conversion conversion;
+    std::size_t text;
+  };
+
+  std::size_t m_count = 0;
+  bool m_default = false;
+  bool m_has_value = false;
+  std::vector<Deferred> m_deferred{};
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  std::pmr::memory_resource* m_resource = nullptr;
+#endif
+};
+
+using ParsedValues = std::vector<OptionValue>;
+
+namespace detail {
+
+// Identifies a set of options, so that a handle is only used with results
+// parsed from the options it was made by
+inline
+std::uint64_t
+next_schema_id()
+{
+#ifdef CXXOPTS_NO_THREADS
+  static std::uint64_t next = 0;
+#else
+  static std::atomic<std::uint64_t> next{0};
+#endif
+  return ++next;
+}
+
+} // namespace detail
+
+// Refers to an option holding a T, by its position in the Options it was
+// added to. Returned by Options::add_option<T>, and read from the results of
+// those options with ParseResult::get without looking the name up.
+template <typename T>
+class OptionHandle
+{
+  public:
+  OptionHandle() = default;
+
+  CXXOPTS_NODISCARD
+  std::size_t
+  index() const noexcept
+  {
+    return m_index;
+  }
+
+  CXXOPTS_NODISCARD
+  bool
+  valid() const noexcept
+  {
+    return m_index != (std::numeric_limits<std::size_t>::max)();
+  }
+
+  private:
+  friend class Options;
+  friend class ParseResult;
+
+  OptionHandle(std::size_t index, std::uint64_t schema)
+  : m_index(index)
+  , m_schema(schema)
+  {
+  }
+
+  std::size_t m_index = (std::numeric_limits<std::size_t>::max)();
+  std::uint64_t m_schema = 0;
+};
+
+class ParseResult
+{
+  public:
+  class Iterator
+  {
+    public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = KeyValue;
+    using difference_type = void;
+    using pointer = const KeyValue*;
+    using reference = const KeyValue&;
+
+    Iterator() = default;
+    Iterator(const Iterator&) = default;
+
+// GCC complains about m_iter not being initialised in the member
+// initializer list
+CXXOPTS_DIAGNOSTIC_PUSH
+CXXOPTS_IGNORE_WARNING("-Weffc++")
+    Iterator(const ParseResult *pr, bool end=false)
+    : m_pr(pr)
+    {
+      if (end)
+      {
+        m_sequential = false;
+        m_iter = m_pr->m_defaults.end();
+      }
+      else
+      {
+        m_sequential = true;
+        m_iter = m_pr->m_sequential.begin();
+
+        if (m_iter == m_pr->m_sequential.end())
+        {
+          m_sequential = false;
+          m_iter = m_pr->m_defaults.begin();
+        }
+      }
+    }
+CXXOPTS_DIAGNOSTIC_POP
+
+    Iterator& operator++()
+    {
+      ++m_iter;
+      if(m_sequential && m_iter == m_pr->m_sequential.end())
+      {
+        m_sequential = false;
+        m_iter = m_pr->m_defaults.begin();
+        return *this;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator retval = *this;
+      ++(*this);
+      return retval;
+    }
+
+    bool operator==(const Iterator& other) const
+    {
+      return (m_sequential == other.m_sequential) && (m_iter == other.m_iter);
+    }
+
+    bool operator!=(const Iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+    const KeyValue& operator*()
+    {
+      return *m_iter;
+    }
+
+    const KeyValue* operator->()
+    {
+      return m_iter.operator->();
+    }
+
+    private:
+    const ParseResult* m_pr;
+    std::vector<KeyValue>::const_iterator m_iter;
+    bool m_sequential = true;
+  };
+
+  ParseResult() = default;
+  ParseResult(const ParseResult&) = default;
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  // The Value and T of each option parsed into this result are allocated
+  // from `resource`, which must outlive the result and any copy of it. The
+  // memory a T allocates itself, and the result's lists of arguments, come
+  // from the global heap.
+  explicit ParseResult(std::pmr::memory_resource* resource)
+  : m_resource(resource)
+  {
+  }
+#endif
+
+  ParseResult(std::shared_ptr<const OptionIndex> index, ParsedValues&& values, std::vector<KeyValue> sequential,
+          std::vector<KeyValue> default_opts, std::vector<std::string>&& unmatched_args)
+  : m_index(std::move(index))
+  , m_values(std::move(values))
+  , m_sequential(std::move(sequential))
+  , m_defaults(std::move(default_opts))
+  , m_unmatched(std::move(unmatched_args))
+  {
+  }
+
+  ParseResult& operator=(ParseResult&&) = default;
+  ParseResult& operator=(const ParseResult&) = default;
+
+  Iterator
+  begin() const
+  {
+    return Iterator(this);
+  }
+
+  Iterator
+  end() const
+  {
+    return Iterator(this, true);
+  }
+
+  std::size_t
+  count(const std::string& o) const
+  {
+    auto value = find_value(o);
+    if (value == nullptr)
+    {
+      return 0;
+    }
+
+    return value->count();
+  }
+
+  bool
+  contains(const std::string& o) const
+  {
+    return static_cast<bool>(count(o));
+  }
+
+  std::size_t
+  count(const OptionKey& key) const
+  {
+    auto details = find_details(key);
+    return details == nullptr ? 0 : m_values[(*details)->index()].count();
+  }
+
+  template <typename T>
+  std::size_t
+  count(const OptionHandle<T>& handle) const
+  {
+    return handle.index() < m_values.size() && owns(handle)
+      ? m_values[handle.index()].count() : 0;
+  }
+
+  // Reads the value of an option by its handle. The type was checked when
+  // the option was added, so this neither looks up a name nor casts
+  // dynamically, and only throws if the option has no value.
+  template <typename T>
+  const T&
+  get(const OptionHandle<T>& handle) const
+  {
+    if (handle.index() >= m_values.size())
+    {
+      throw_or_mimic<exceptions::option_has_no_value>("");
+    }
+    if (!owns(handle))
+    {
+      throw_or_mimic<exceptions::foreign_option_handle>(
+        std::to_string(handle.index()));
+    }
+
+    convert(handle.index());
+    return m_values[handle.index()].template as_unchecked<T>();
+  }
+
+  // As operator[](key.name()).as<T>(), with the name hashed at compile time
+  template <typename T>
+  const T&
+  get(const OptionKey& key) const
+  {
+    auto details = find_details(key);
+    if (details == nullptr)
+    {
+      throw_or_mimic<exceptions::requested_option_not_present>(key.name());
+    }
+
+    convert((*details)->index());
+    return m_values[(*details)->index()].template as<T>();
+  }
+
+  const OptionValue&
+  operator[](const std::string& option) const
+  {
+    auto value = find_converted(option);
+
+    if (value == nullptr)
+    {
+      throw_or_mimic<exceptions::requested_option_not_present>(option);
+    }
+
+    return *value;
+  }
+
+#ifdef CXXOPTS_HAS_OPTIONAL
+  template <typename T>
+  std::optional<T>
+  as_optional(const std::string& option) const
+  {
+    auto value = find_converted(option);
+    if (value != nullptr)
+    {
+      return value->as_optional<T>();
+    }
+    return std::nullopt;
+  }
+#endif
+
+  // Converts every value left unconverted by Options::set_lazy_conversion,
+  // so that conversion errors are reported here instead of on access.
+  void
+  validate() const
+  {
+    for (std::size_t i = 0; i != m_values.size() && m_pending.count() != 0; ++i)
+    {
+      convert(i);
+    }
+  }
+
+  const std::vector<KeyValue>&
+  arguments() const
+  {
+    return m_sequential;
+  }
+
+  const std::vector<std::string>&
+  unmatched() const
+  {
+    return m_unmatched;
+  }
+
+  const std::vector<KeyValue>&
+  defaults() const
+  {
+    return m_defaults;
+  }
+
+  const std::string
+  arguments_string() const
+  {
+    std::string result;
+    for(const auto& kv: m_sequential)
+    {
+      result += kv.key() + " = " + kv.value() + "\n";
+    }
+    for(const auto& kv: m_defaults)
+    {
+      result += kv.key() + " = " + kv.value() + " " + "(default)" + "\n";
+    }
+    return result;
+  }
+
+  private:
+  friend class OptionParser;
+
+  template <typename T>
+  bool
+  owns(const OptionHandle<T>& handle) const
+  {
+    return m_index->schema() == handle.m_schema;
+  }
+
+  // Leaves the result as if nothing had been parsed, keeping its buffers
+  void
+  clear()
+  {
+    reset(m_index);
+    m_sequential.clear();
+    m_defaults.clear();
+    m_unmatched.clear();
+  }
+
+  void
+  reset(const std::shared_ptr<const OptionIndex>& index)
+  {
+    if (m_index != index)
+    {
+      m_index = index;
+      m_values.clear();
+    }
+
+    m_pending.set(0);
+    m_values.resize(m_index->options().size());
+    for (auto& value : m_values)
+    {
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+      value.reset(m_resource);
+#else
+      value.reset();
+#endif
+    }
+  }
+
+  template <typename Name>
+  const std::shared_ptr<OptionDetails>*
+  find_details(const Name& option) const
+  {
+    if (m_index == nullptr)
+    {
+      return nullptr;
+    }
+
+    auto details = m_index->find(option);
+    if (details == nullptr || (*details)->index() >= m_values.size())
+    {
+      return nullptr;
+    }
+
+    return details;
+  }
+
+  const OptionValue*
+  find_value(const std::string& option) const
+  {
+    auto details = find_details(option);
+    return details == nullptr ? nullptr : &m_values[(*details)->index()];
+  }
+
+  // As find_value, and converts the value first if it was deferred
+  const OptionValue*
+  find_converted(const std::string& option) const
+  {
+    auto details = find_details(option);
+    if (details == nullptr)
+    {
+      return nullptr;
+    }
+
+    convert((*details)->index());
+    return &m_values[(*details)->index()];
+  }
+
+  // Converts the value at `index` if its conversion was deferred. Only the
+  // first of several threads reading it at once converts it.
+  void
+  convert(std::size_t index) const
+  {
+    if (m_pending.count() == 0)
+    {
+      return;
+    }
+
+    m_pending.run([&]() {
+      auto& value = m_values[index];
+      if (!value.deferred())
+      {
+        return false;
+      }
+      value.convert(m_index->options()[index], m_sequential);
+      return true;
+    });
+  }
+
+  // Shared with the Options that produced this result and every other result
+  // parsed from the same set of options.
+  std::shared_ptr<const OptionIndex> m_index{};
+  // Values whose conversion was deferred are converted on first access,
+  // under m_pending
+  mutable ParsedValues m_values{};
+  mutable detail::PendingConversions m_pending{};
+  std::vector<KeyValue> m_sequential{};
+  std::vector<KeyValue> m_defaults{};
+  std::vector<std::string> m_unmatched{};
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  std::pmr::memory_resource* m_resource = nullptr;
+#endif
+};
+
+struct Option
+{
+  Option
+  (
+    std::string opts,
+    std::string desc,
+    std::shared_ptr<const Value>  value = ::cxxopts::value<bool>(),
+    std::string arg_help = ""
+  )
+  : opts_(std::move(opts))
+  , desc_(std::move(desc))
+  , value_(std::move(value))
+  , arg_help_(std::move(arg_help))
+  {
+  }
+
+  std::string opts_;
+  std::string desc_;
+  std::shared_ptr<const Value> value_;
+  std::string arg_help_;
+};
+
+using PositionalList = std::vector<std::string>;
+using PositionalListIterator = PositionalList::const_iterator;
+
+// Receives the text of each argument of a parse, instead of a ParseResult
+// holding converted values, see Options::parse_into and Binder. Converting the
+// text is up to the sink. Options that are not given get parse_default if they
+// have a default value.
+class ParseSink
+{
+  public:
+  virtual ~ParseSink() = default;
+
+  // Converts the argument of an option
+  virtual void
+  parse(const OptionDetails& details, const std::string& text) = 0;
+
+  // Converts a positional argument, which adds a single element to a list
+  // instead of splitting it
+  virtual void
+  add(const OptionDetails& details, const std::string& text) = 0;
+
+  virtual void
+  parse_default(const OptionDetails& details) = 0;
+
+  // An argument skipped because of Options::allow_unrecognised_options
+  virtual void
+  unmatched(const char* arg) = 0;
+};
+
+class OptionParser
+{
+  public:
+  OptionParser
+  (
+    std::shared_ptr<const OptionIndex> index,
+    const PositionalList& positional,
+    bool allow_unrecognised,
+    bool lazy = false
+  )
+  : m_index(std::move(index))
+  , m_positional(positional)
+  , m_allow_unrecognised(allow_unrecognised)
+  , m_lazy(lazy)
+  {
+  }
+
+  OptionParser(const OptionParser&) = delete;
+  OptionParser& operator=(const OptionParser&) = delete;
+
+  ParseResult
+  parse(int argc, const char* const* argv);
+
+  // Parses into an existing result, reusing the storage it kept from an
+  // earlier parse.
+  void
+  parse_into(ParseResult& result, int argc, const char* const* argv);
+
+  // Parses into a sink. Nothing is recorded apart from what the sink keeps.
+  void
+  parse_into(ParseSink& sink, int argc, const char* const* argv);
+
+  bool
+  consume_positional(const char* a, PositionalListIterator& next);
+
+  void
+  checked_parse_arg
+  (
+    int argc,
+    const char* const* argv,
+    int& current,
+    const std::shared_ptr<OptionDetails>& value,
+    const std::string& name
+  );
+
+  void
+  add_to_option(const std::shared_ptr<OptionDetails>& value, const char* arg);
+
+  void
+  parse_option
+  (
+    const std::shared_ptr<OptionDetails>& value,
+    const std::string& name,
+    const char* arg = ""
+  );
+
+  void
+  parse_default(const std::shared_ptr<OptionDetails>& details);
+
+  void
+  parse_no_value(const std::shared_ptr<OptionDetails>& details);
+
+  private:
+
+  // The loop shared by both parse_into, which writes to m_result or m_sink
+  void
+  parse_arguments(int argc, const char* const* argv);
+
+  // Occurrences of an option so far in this parse
+  std::size_t
+  count(const OptionDetails& details) const
+  {
+    return m_sink != nullptr
+      ? m_counts[details.index()]
+      : m_result->m_values[details.index()].count();
+  }
+
+  // Appends to one of the result's argument lists, overwriting an entry left
+  // from an earlier parse when there is one.
+  const std::string&
+  record
+  (
+    std::vector<KeyValue>& list,
+    std::size_t& used,
+    StringView key,
+    const char* value
+  );
+
+  void
+  add_unmatched(const char* arg);
+
+  // Whether values with their own storage are converted on first access
+  // instead of while parsing
+  bool
+  defers(const OptionDetails& details) const
+  {
+    return m_lazy && !details.value().has_external_storage();
+  }
+
+  std::shared_ptr<const OptionIndex> m_index;
+  const PositionalList& m_positional;
+  bool m_allow_unrecognised;
+  bool m_lazy;
+
+  ParseResult* m_result = nullptr;
+  std::size_t m_sequential_used = 0;
+  std::size_t m_defaults_used = 0;
+  std::size_t m_unmatched_used = 0;
+
+  ParseSink* m_sink = nullptr;
+  std::vector<std::size_t> m_counts{};
+  std::string m_text{};
+};
+
+// An immutable snapshot of a set of options, made by Options::compile. Any
+// number of threads may parse with the same CompiledOptions at once, without
+// locking, as long as each parses into its own result. Options bound to an
+// external variable with value(T&) write to that variable, so they are only
+// safe to parse from one thread at a time. Later changes to the Options that
+// made the snapshot are not seen by it.
+class CompiledOptions
+{
+  public:
+  CompiledOptions
+  (
+    std::shared_ptr<const OptionIndex> index,
+    PositionalList positional,
+    bool allow_unrecognised,
+    bool lazy_conversion = false
+  )
+  : m_index(std::move(index))
+  , m_positional(std::move(positional))
+  , m_allow_unrecognised(allow_unrecognised)
+  , m_lazy_conversion(lazy_conversion)
+  {
+  }
+
+  ParseResult
+  parse(int argc, const char* const* argv) const;
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  ParseResult
+  parse(int argc, const char* const* argv, std::pmr::memory_resource* resource) const;
+#endif
+
+  void
+  parse_into(ParseResult& result, int argc, const char* const* argv) const;
+
+  const OptionIndex&
+  index() const
+  {
+    return *m_index;
+  }
+
+  private:
+  std::shared_ptr<const OptionIndex> m_index;
+  PositionalList m_positional;
+  bool m_allow_unrecognised;
+  bool m_lazy_conversion;
+};
+
+namespace detail {
+
+// Help text already rendered by Options::help, by the groups asked for and
+// whether the usage was printed, and the details of each group asked for by
+// Options::group_help. Several threads may look up and insert at once. A copy
+// starts out empty, since it belongs to another Options.
+class HelpCache
+{
+  public:
+  HelpCache() = default;
+
+  HelpCache(const HelpCache&)
+  : HelpCache()
+  {
+  }
+
+  HelpCache&
+  operator=(const HelpCache&)
+  {
+    Lock lock(m_mutex);
+    m_entries.clear();
+    m_groups.clear();
+    return *this;
+  }
+
+  bool
+  find(const std::vector<std::string>& groups, bool print_usage, std::string& help) const
+  {
+    Lock lock(m_mutex);
+    const auto entry = m_entries.find(Key(groups, print_usage));
+    if (entry == m_entries.end())
+    {
+      return false;
+    }
+    help = entry->second;
+    return true;
+  }
+
+  void
+  insert(const std::vector<std::string>& groups, bool print_usage, const std::string& help)
+  {
+    Lock lock(m_mutex);
+    m_entries.emplace(Key(groups, print_usage), help);
+  }
+
+  // The details of a group, filled in by build the first time it is asked for.
+  // They stay where they are until the cache is destroyed, so the reference
+  // returned is not invalidated by clear.
+  template <typename Build>
+  const HelpGroupDetails&
+  group(const std::string& name, Build build)
+  {
+    Lock lock(m_mutex);
+    auto found = m_groups.find(name);
+    if (found == m_groups.end())
+    {
+      found = m_groups.emplace(name, HelpGroupDetails{}).first;
+      build(found->second);
+    }
+    return found->second;
+  }
+
+  // Adds an option to the details of its group, if they were built
+  void
+  add_to_group(const std::string& name, const HelpEntry& entry)
+  {
+    Lock lock(m_mutex);
+    auto found = m_groups.find(name);
+    if (found != m_groups.end())
+    {
+      found->second.options.push_back(help_details(entry));
+    }
+  }
+
+  // Drops the rendered text, after the options or a help setting changed
+  void
+  clear()
+  {
+    Lock lock(m_mutex);
+    m_entries.clear();
+  }
+
+  private:
+  using Key = std::pair<std::vector<std::string>, bool>;
+
+  mutable Mutex m_mutex{};
+  std::map<Key, std::string> m_entries{};
+  std::map<std::string, HelpGroupDetails> m_groups{};
+};
+
+// Where Options renders help text to: a String, or a stream that each piece
+// is written to as soon as it is rendered, so that the whole text is never
+// held at once.
+class HelpWriter
+{
+  public:
+  explicit HelpWriter(String& text)
+  : m_text(&text)
+  {
+  }
+
+  explicit HelpWriter(std::ostream& out)
+  : m_out(&out)
+  {
+  }
+
+  HelpWriter(const HelpWriter&) = delete;
+  HelpWriter& operator=(const HelpWriter&) = delete;
+
+  void
+  write(const String& text)
+  {
+    if (m_out == nullptr)
+    {
+      *m_text += text;
+      return;
+    }
+#ifdef CXXOPTS_USE_UNICODE
+    const auto utf8 = toUTF8String(text);
+    m_out->write(utf8.data(), static_cast<std::streamsize>(utf8.size()));
+#else
+    m_out->write(text.data(), static_cast<std::streamsize>(text.size()));
+#endif
+  }
+
+  private:
+  String* m_text = nullptr;
+  std::ostream* m_out = nullptr;
+};
+
+} // namespace detail
+
+class Options
+{
+  public:
+
+  explicit Options(std::string program_name, std::string help_string = "")
+  : m_program(std::move(program_name))
+  , m_help_string(toLocalString(std::move(help_string)))
+  , m_custom_help("[OPTION...]")
+  , m_positional_help("positional parameters")
+  , m_show_positional(false)
+  , m_allow_unrecognised(false)
+  , m_width(76)
+  , m_tab_expansion(false)
+  , m_lazy_conversion(false)
+  , m_options(std::make_shared<OptionMap>())
+  , m_strings(std::make_shared<detail::StringPool>())
+  , m_schema(detail::next_schema_id())
+  , m_option_count(std::make_shared<std::size_t>(0))
+  {
+  }
+
+  Options&
+  positional_help(std::string help_text)
+  {
+    m_positional_help = std::move(help_text);
+    m_help_cache.clear();
+    return *this;
+  }
+
+  Options&
+  custom_help(std::string help_text)
+  {
+    m_custom_help = std::move(help_text);
+    m_help_cache.clear();
+    return *this;
+  }
+
+  Options&
+  show_positional_help()
+  {
+    m_show_positional = true;
+    m_help_cache.clear();
+    return *this;
+  }
+
+  Options&
+  allow_unrecognised_options()
+  {
+    m_allow_unrecognised = true;
+    return *this;
+  }
+
+  Options&
+  set_width(std::size_t width)
+  {
+    m_width = width;
+    m_help_cache.clear();
+    return *this;
+  }
+
+  Options&
+  set_tab_expansion(bool expansion=true)
+  {
     m_tab_expansion = expansion;
+    m_help_cache.clear();
+    return *this;
+  }
+
+  // Parsing then only records the text of each argument, and an option's
+  // value is converted the first time it is read from the result, or by
+  // ParseResult::validate. Conversion errors are reported at that point.
+  // Options bound to a variable with value(T&) are still converted while
+  // parsing. Reading converts each value once under a lock, so a result can
+  // still be read from several threads at once, but not copied while it is.
+  Options&
+  set_lazy_conversion(bool lazy=true)
+  {
+    m_lazy_conversion = lazy;
+    return *this;
+  }
+
+  ParseResult
+  parse(int argc, const char* const* argv);
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+  // Parses with the Value and T of each option allocated from `resource`,
+  // for example a std::pmr::monotonic_buffer_resource that is released after
+  // the parse. Memory a T allocates itself, such as the elements of a
+  // vector, comes from the global heap, see ParseResult(memory_resource*).
+  // The result, and any copy of it, must not be used after the resource is
+  // released.
+  ParseResult
+  parse(int argc, const char* const* argv, std::pmr::memory_resource* resource);
+#endif
+
+  // Parses into an existing result. Its buffers and value storage are reused,
+  // so parsing repeatedly into the same result allocates very little. If the
+  // parse throws, the result is left empty; variables given to value(T&) may
+  // still hold what was parsed before the error.
+  void
+  parse_into(ParseResult& result, int argc, const char* const* argv);
+
+  // Parses into a sink, which receives each value as it is converted instead
+  // of a ParseResult holding them.
+  void
+  parse_into(ParseSink& sink, int argc, const char* const* argv);
+
+  // Takes an immutable snapshot of the options that can be shared by
+  // threads parsing concurrently.
+  CompiledOptions
+  compile();
+
+  // Builds the name lookup table used while parsing. parse does this on
+  // demand, so this only moves the cost up front. Adding an option discards
+  // the table again.
+  void
+  freeze();
+
+  // Every name in `schema` must be the name of an option by the time the
+  // options are next frozen, otherwise freeze, and so parse, throws
+  // no_such_option. This ties the keys made from the schema to the options
+  // they are read from.
+  Options&
+  add_schema(const OptionSchema& schema)
+  {
+    m_schemas.push_back(schema);
+    m_index.reset();
     return *this;
   }
 
-  ParseResult
-  parse(int argc, const char* const* argv);
+  OptionAdder
+  add_options(std::string group = "");
+
+  void
+  add_options
+  (
+    const std::string& group,
+    std::initializer_list<Option> options
+  );
+
+  // Adds a table of options whose names were already split by OptionSpec,
+  // usually at compile time.
+  template <std::size_t N>
+  void
+  add_options(const std::string& group, const OptionSpec (&specs)[N])
+  {
+    add_options(group, specs, specs + N);
+  }
+
+  void
+  add_options
+  (
+    const std::string& group,
+    const OptionSpec* first,
+    const OptionSpec* last
+  );
+
+  void
+  add_option
+  (
+    const std::string& group,
+    const Option& option
+  );
+
+  void
+  add_option
+  (
+    const std::string& group,
+    const std::string& s,
+    const OptionNames& l,
+    std::string desc,
+    const std::shared_ptr<const Value>& value,
+    std::string arg_help
+  );
+
+  // Adds an option as add_options()(opts, desc, value, arg_help) does, and
+  // returns a handle to read its value with. The value must be a T, such as
+  // one made by cxxopts::value<T>().
+  template <typename T>
+  OptionHandle<T>
+  add_option
+  (
+    const std::string& group,
+    const std::string& opts,
+    const std::string& desc,
+    const std::shared_ptr<const Value>& value = ::cxxopts::value<T>(),
+    std::string arg_help = ""
+  );
+
+  void
+  add_option
+  (
+    const std::string& group,
+    const std::string& short_name,
+    const std::string& single_long_name,
+    std::string desc,
+    const std::shared_ptr<const Value>& value,
+    std::string arg_help
+  )
+  {
+    OptionNames long_names;
+    long_names.emplace_back(single_long_name);
+    add_option(group, short_name, long_names, desc, value, arg_help);
+  }
+
+  //parse positional arguments into the given option
+  void
+  parse_positional(std::string option, PositionalMode mode = PositionalMode::Replace);
+
+  void
+  parse_positional(std::vector<std::string> options, PositionalMode mode = PositionalMode::Replace);
+
+  void
+  parse_positional(std::initializer_list<std::string> options, PositionalMode mode = PositionalMode::Replace);
+
+  template <typename Iterator>
+  void
+  parse_positional(Iterator begin, Iterator end, PositionalMode mode = PositionalMode::Replace) {
+    parse_positional(std::vector<std::string>{begin, end}, mode);
+  }
+
+  // The help text is rendered once for each set of groups and print_usage,
+  // and kept until the options or the help settings change. A Value changed
+  // after it was added, such as given a new default, does not count as a
+  // change. Any number of threads may ask for help at once.
+  std::string
+  help(const std::vector<std::string>& groups = {}, bool print_usage=true) const;
+
+  // Writes the same text as help to `out`, one option at a time, without
+  // building the whole text or caching it. Whether the writes are buffered
+  // is up to the stream.
+  void
+  help_to
+  (
+    std::ostream& out,
+    const std::vector<std::string>& groups = {},
+    bool print_usage = true
+  ) const;
+
+  std::vector<std::string>
+  groups() const;
+
+  // The help of every option in a group, read from the options the first
+  // time the group is asked for. The reference stays valid as long as the
+  // Options, and options added to the group later are appended to it. Changes
+  // made to a Value after that, such as a new default, are not seen, nor by
+  // help once it has rendered the text.
+  const HelpGroupDetails&
+  group_help(const std::string& group) const;
+
+  const std::string& program() const
+  {
+    return m_program;
+  }
+
+  private:
 
-  OptionAdder
-  add_options(std::string group = "");
+  friend class OptionAdder;
 
+  // Adds an option whose long names are the StringViews, or strings, from
+  // first to last. The names and description are copied into m_strings.
+  template <typename Iterator>
   void
-  add_options
+  add_split_option
   (
     const std::string& group,
-    std::initializer_list<Option> options
+    StringView s,
+    Iterator first,
+    Iterator last,
+    StringView desc,
+    const std::shared_ptr<const Value>& value,
+    StringView arg_help
   );
 
   void
-  add_option
+  add_one_option
   (
-    const std::string& group,
-    const Option& option
+    StringView option,
+    const std::shared_ptr<OptionDetails>& details
   );
 
   void
-  add_option
+  remove_option_names(const std::shared_ptr<OptionDetails>& details);
+
+  bool
+  visible_in_help(const detail::HelpEntry& entry) const;
+
+  // Returns false, and writes nothing, when the group has nothing to show
+  bool
+  write_group_help(const std::string& group, detail::HelpWriter& out) const;
+
+  void
+  write_help
   (
-    const std::string& group,
-    const std::string& s,
-    const OptionNames& l,
-    std::string desc,
-    const std::shared_ptr<const Value>& value,
-    std::string arg_help
+    detail::HelpWriter& out,
+    const std::vector<std::string>& groups,
+    bool print_usage
+  ) const;
+
+  std::string m_program{};
+  String m_help_string{};
+  std::string m_custom_help{};
+  std::string m_positional_help{};
+  bool m_show_positional;
+  bool m_allow_unrecognised;
+  std::size_t m_width;
+  bool m_tab_expansion;
+  bool m_lazy_conversion;
+
+  std::shared_ptr<OptionMap> m_options;
+  std::shared_ptr<detail::StringPool> m_strings;
+  // Copies share m_options, and with it the schema and the count of options
+  // that the next option takes its index from
+  std::uint64_t m_schema;
+  std::shared_ptr<std::size_t> m_option_count;
+  std::shared_ptr<const OptionIndex> m_index{};
+  std::vector<OptionSchema> m_schemas{};
+  std::vector<std::string> m_positional{};
+  std::unordered_set<std::string> m_positional_set{};
+
+  //mapping from groups to help options
+  std::vector<std::string> m_group{};
+  std::map<std::string, std::vector<detail::HelpEntry>> m_help{};
+  mutable detail::HelpCache m_help_cache{};
+};
+
+class OptionAdder
+{
+  public:
+
+  OptionAdder(Options& options, std::string group)
+  : m_options(options), m_group(std::move(group))
+  {
+  }
+
+  OptionAdder&
+  operator()
+  (
+    const std::string& opts,
+    const std::string& desc,
+    const std::shared_ptr<const Value>& value
+      = ::cxxopts::value<bool>(),
+    std::string arg_help = ""
   );
 
-  void
-  add_option
+#ifdef CXXOPTS_HAS_CONSTEVAL
+  // Adds an option whose names were split at compile time
+  OptionAdder&
+  operator()
   (
-    const std::string& group,
-    const std::string& short_name,
-    const std::string& single_long_name,
-    std::string desc,
-    const std::shared_ptr<const Value>& value,
-    std::string arg_help
+    const OptionNamesLiteral& names,
+    const std::string& desc,
+    const std::shared_ptr<const Value>& value
+      = ::cxxopts::value<bool>(),
+    std::string arg_help = ""
   )
   {
-    OptionNames long_names;
-    long_names.emplace_back(single_long_name);
-    add_option(group, short_name, long_names, desc, value, arg_help);
+    StringView short_name;
+    StringView long_names[OptionSpec::MAX_NAMES];
+    const auto count = names.spec().split_names(short_name, long_names);
+    m_options.add_split_option(m_group, short_name, long_names,
+      long_names + count, desc, value, arg_help);
+    return *this;
+  }
+#endif
+
+  // Adds an option and stores a handle to read its value with in `handle`
+  template <typename T>
+  OptionAdder&
+  operator()
+  (
+    OptionHandle<T>& handle,
+    const std::string& opts,
+    const std::string& desc,
+    const std::shared_ptr<const Value>& value = ::cxxopts::value<T>(),
+    std::string arg_help = ""
+  )
+  {
+    handle = m_options.add_option<T>(m_group, opts, desc, value, std::move(arg_help));
+    return *this;
+  }
+
+  private:
+  Options& m_options;
+  std::string m_group;
+};
+
+// Binds options to the members of a struct, made by bind<Config>(options).
+// Parsing converts each argument straight into the member, without a
+// ParseResult or a copy of any Value. Members keep their value when an
+// option is not given and has no default, and list members are appended to.
+// Options added to the same Options in other ways are still recognised, and
+// a missing argument is still an error, but their arguments are neither
+// converted nor checked, only dropped. The Binder must outlive its parses.
+template <typename Config>
+class Binder
+{
+  public:
+  Binder(Options& options, std::string group)
+  : m_options(options)
+  , m_group(std::move(group))
+  {
+  }
+
+  // Adds an option as add_options() does, stored in `member`. The value
+  // describes the option, and must be a T as made by cxxopts::value<T>().
+  template <typename T>
+  Binder&
+  add
+  (
+    const std::string& opts,
+    T Config::* member,
+    const std::string& desc,
+    const std::shared_ptr<const Value>& value = ::cxxopts::value<T>(),
+    std::string arg_help = ""
+  )
+  {
+    const auto handle = m_options.add_option<T>(m_group, opts, desc, value,
+      std::move(arg_help));
+    if (handle.index() >= m_fields.size())
+    {
+      m_fields.resize(handle.index() + 1);
+    }
+
+    auto& field = m_fields[handle.index()];
+    // Members of every type are kept as one type, and cast back by the
+    // functions instantiated for their real type.
+    field.member = reinterpret_cast<char Config::*>(member);
+    field.parse = &parse_member<T>;
+    field.add = &add_member<T>;
+    field.format =
+      static_cast<const values::abstract_value<T>&>(*value).list_format();
+    return *this;
   }
 
-  //parse positional arguments into the given option
   void
-  parse_positional(std::string option, PositionalMode mode = PositionalMode::Replace);
+  parse(Config& config, int argc, const char* const* argv) const
+  {
+    Sink sink(*this, config, nullptr);
+    m_options.parse_into(sink, argc, argv);
+  }
 
+  // As parse, and stores the arguments skipped because of
+  // Options::allow_unrecognised_options in `unmatched`
   void
-  parse_positional(std::vector<std::string> options, PositionalMode mode = PositionalMode::Replace);
+  parse
+  (
+    Config& config,
+    int argc,
+    const char* const* argv,
+    std::vector<std::string>& unmatched
+  ) const
+  {
+    unmatched.clear();
+    Sink sink(*this, config, &unmatched);
+    m_options.parse_into(sink, argc, argv);
+  }
+
+  private:
+  using Convert = void (*)(Config&, char Config::*, const std::string&,
+    const values::ListFormat&);
+
+  struct Field
+  {
+    char Config::* member = nullptr;
+    Convert parse = nullptr;
+    Convert add = nullptr;
+    values::ListFormat format{};
+  };
 
+  template <typename T>
+  static
   void
-  parse_positional(std::initializer_list<std::string> options, PositionalMode mode = PositionalMode::Replace);
+  parse_member
+  (
+    Config& config,
+    char Config::* member,
+    const std::string& text,
+    const values::ListFormat& format
+  )
+  {
+    values::parse_value(text, config.*reinterpret_cast<T Config::*>(member), format);
+  }
+
+  template <typename T>
+  static
+  void
+  add_member
+  (
+    Config& config,
+    char Config::* member,
+    const std::string& text,
+    const values::ListFormat&
+  )
+  {
+    values::add_value(text, config.*reinterpret_cast<T Config::*>(member));
+  }
+
+  class Sink : public ParseSink
+  {
+    public:
+    Sink(const Binder& binder, Config& config, std::vector<std::string>* unmatched)
+    : m_binder(binder)
+    , m_config(config)
+    , m_unmatched(unmatched)
+    {
+    }
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    void
+    parse(const OptionDetails& details, const std::string& text) override
+    {
+      const auto* field = m_binder.find(details);
+      if (field != nullptr)
+      {
+        field->parse(m_config, field->member, text, field->format);
+      }
+    }
+
+    void
+    add(const OptionDetails& details, const std::string& text) override
+    {
+      const auto* field = m_binder.find(details);
+      if (field != nullptr)
+      {
+        field->add(m_config, field->member, text, field->format);
+      }
+    }
+
+    void
+    parse_default(const OptionDetails& details) override
+    {
+      const auto* field = m_binder.find(details);
+      if (field != nullptr)
+      {
+        field->parse(m_config, field->member, details.value().get_default_value(),
+          field->format);
+      }
+    }
+
+    void
+    unmatched(const char* arg) override
+    {
+      if (m_unmatched != nullptr)
+      {
+        m_unmatched->emplace_back(arg);
+      }
+    }
+
+    private:
+    const Binder& m_binder;
+    Config& m_config;
+    std::vector<std::string>* m_unmatched;
+  };
+
+  const Field*
+  find(const OptionDetails& details) const
+  {
+    return details.index() < m_fields.size() && m_fields[details.index()].parse != nullptr
+      ? &m_fields[details.index()]
+      : nullptr;
+  }
+
+  Options& m_options;
+  std::string m_group;
+  std::vector<Field> m_fields{};
+};
+
+template <typename Config>
+Binder<Config>
+bind(Options& options, std::string group = "")
+{
+  return Binder<Config>(options, std::move(group));
+}
+
+// Support for the parsers written by cxxopts-codegen, which turns a file of
+// option specs into a header with a struct holding every option and a
+// function parsing straight into it. The names are looked up in a perfect
+// hash laid out when the header is generated, and each option is converted
+// by a switch instead of through an OptionMap and Value.
+namespace codegen {
+
+// A name in a generated table, at `offset` in the table's names
+struct NameEntry
+{
+  std::size_t offset;
+  std::size_t length;
+  std::size_t option;
+};
+
+struct OptionInfo
+{
+  // nullptr when the option has none
+  const char* default_value;
+  const char* implicit_value;
+  bool container;
+};
+
+struct Schema
+{
+  const char* names;
+  const NameEntry* entries;
+  const std::uint32_t* displacements;
+  std::uint64_t bucket_mask;
+  const std::uint32_t* slots;
+  std::uint64_t slot_mask;
+  const OptionInfo* options;
+  std::size_t option_count;
+  const std::size_t* positional;
+  std::size_t positional_count;
+  bool allow_unrecognised;
+
+  // The option of a name, or nullptr
+  const NameEntry*
+  find(const char* name, std::size_t length) const
+  {
+    const auto hash = detail::hash_name(name, length);
+    const auto slot = detail::perfect_hash_slot(displacements, bucket_mask,
+      slots, slot_mask, hash);
+    if (slot == 0)
+    {
+      return nullptr;
+    }
+
+    const auto& entry = entries[slot - 1];
+    if (entry.length != length ||
+        std::memcmp(names + entry.offset, name, length) != 0)
+    {
+      return nullptr;
+    }
+    return &entry;
+  }
+};
+
+// Parses the arguments the same way as Options::parse. `convert` is called
+// as convert(option, text, add) for each value, with `add` true for a
+// positional argument, which adds a single element to a list instead of
+// splitting it. `counts` holds a count for each option.
+template <typename Convert>
+class Parser
+{
+  public:
+  Parser
+  (
+    const Schema& schema,
+    std::size_t* counts,
+    std::vector<std::string>& unmatched,
+    Convert& convert
+  )
+  : m_schema(schema)
+  , m_counts(counts)
+  , m_unmatched(unmatched)
+  , m_convert(convert)
+  {
+  }
+
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
+
+  void
+  parse(int argc, const char* const* argv)
+  {
+    int current = 1;
+    bool consume_remaining = false;
+    std::size_t next_positional = 0;
+
+    while (current < argc)
+    {
+      if (strcmp(argv[current], "--") == 0)
+      {
+        consume_remaining = true;
+        ++current;
+        break;
+      }
+
+      values::parser_tool::ArguScan scan;
+      if (!values::parser_tool::scan_argument(argv[current], scan))
+      {
+        if (argv[current][0] == '-' && argv[current][1] != '\0' &&
+            !m_schema.allow_unrecognised)
+        {
+          throw_or_mimic<exceptions::invalid_option_syntax>(argv[current]);
+        }
+
+        if (!consume_positional(argv[current], next_positional))
+        {
+          m_unmatched.emplace_back(argv[current]);
+        }
+      }
+      else if (scan.grouping)
+      {
+        for (std::size_t i = 0; i != scan.name_length; ++i)
+        {
+          const auto* entry = m_schema.find(scan.name + i, 1);
+          if (entry == nullptr)
+          {
+            if (m_schema.allow_unrecognised)
+            {
+              const char unknown[] = {'-', scan.name[i], '\0'};
+              m_unmatched.emplace_back(unknown);
+              continue;
+            }
+            throw_or_mimic<exceptions::no_such_option>(std::string(1, scan.name[i]));
+          }
+
+          const auto& info = m_schema.options[entry->option];
+          if (i + 1 == scan.name_length)
+          {
+            if (scan.set_value)
+            {
+              parse_option(entry->option, scan.value);
+            }
+            else
+            {
+              checked_parse_arg(argc, argv, current, entry->option,
+                std::string(1, scan.name[i]));
+            }
+          }
+          else if (info.implicit_value != nullptr)
+          {
+            parse_option(entry->option, info.implicit_value);
+          }
+          else
+          {
+            // the rest of the group is the value
+            parse_option(entry->option, scan.name + i + 1);
+            break;
+          }
+        }
+      }
+      else
+      {
+        const auto* entry = m_schema.find(scan.name, scan.name_length);
+        if (entry == nullptr)
+        {
+          if (m_schema.allow_unrecognised)
+          {
+            m_unmatched.emplace_back(argv[current]);
+            ++current;
+            continue;
+          }
+          throw_or_mimic<exceptions::no_such_option>(
+            std::string(scan.name, scan.name_length));
+        }
 
-  template <typename Iterator>
-  void
-  parse_positional(Iterator begin, Iterator end, PositionalMode mode = PositionalMode::Replace) {
-    parse_positional(std::vector<std::string>{begin, end}, mode);
-  }
+        if (scan.set_value)
+        {
+          parse_option(entry->option, scan.value);
+        }
+        else
+        {
+          checked_parse_arg(argc, argv, current, entry->option,
+            std::string(scan.name, scan.name_length));
+        }
+      }
 
-  std::string
-  help(const std::vector<std::string>& groups = {}, bool print_usage=true) const;
+      ++current;
+    }
 
-  std::vector<std::string>
-  groups() const;
+    for (std::size_t option = 0; option != m_schema.option_count; ++option)
+    {
+      const auto* default_value = m_schema.options[option].default_value;
+      if (default_value != nullptr && m_counts[option] == 0)
+      {
+        m_text.assign(default_value);
+        m_convert(option, m_text, false);
+      }
+    }
 
-  const HelpGroupDetails&
-  group_help(const std::string& group) const;
+    if (consume_remaining)
+    {
+      while (current < argc && consume_positional(argv[current], next_positional))
+      {
+        ++current;
+      }
 
-  const std::string& program() const
-  {
-    return m_program;
+      for (; current < argc; ++current)
+      {
+        m_unmatched.emplace_back(argv[current]);
+      }
+    }
   }
 
   private:
-
   void
-  add_one_option
-  (
-    const std::string& option,
-    const std::shared_ptr<OptionDetails>& details
-  );
-
-  String
-  help_one_group(const std::string& group) const;
+  parse_option(std::size_t option, const char* arg, bool add = false)
+  {
+    ++m_counts[option];
+    m_text.assign(arg);
+    m_convert(option, m_text, add);
+  }
 
   void
-  generate_group_help
+  checked_parse_arg
   (
-    String& result,
-    const std::vector<std::string>& groups
-  ) const;
-
-  void
-  generate_all_groups_help(String& result) const;
-
-  std::string m_program{};
-  String m_help_string{};
-  std::string m_custom_help{};
-  std::string m_positional_help{};
-  bool m_show_positional;
-  bool m_allow_unrecognised;
-  std::size_t m_width;
-  bool m_tab_expansion;
+    int argc,
+    const char* const* argv,
+    int& current,
+    std::size_t option,
+    const std::string& name
+  )
+  {
+    const auto* implicit_value = m_schema.options[option].implicit_value;
+    if (implicit_value != nullptr)
+    {
+      parse_option(option, implicit_value);
+    }
+    else if (current + 1 >= argc)
+    {
+      throw_or_mimic<exceptions::missing_argument>(name);
+    }
+    else
+    {
+      parse_option(option, argv[current + 1]);
+      ++current;
+    }
+  }
 
-  std::shared_ptr<OptionMap> m_options;
-  std::vector<std::string> m_positional{};
-  std::unordered_set<std::string> m_positional_set{};
+  bool
+  consume_positional(const char* arg, std::size_t& next)
+  {
+    for (; next != m_schema.positional_count; ++next)
+    {
+      const auto option = m_schema.positional[next];
+      if (m_schema.options[option].container)
+      {
+        parse_option(option, arg, true);
+        return true;
+      }
+      if (m_counts[option] == 0)
+      {
+        parse_option(option, arg, true);
+        ++next;
+        return true;
+      }
+    }
+    return false;
+  }
 
-  //mapping from groups to help options
-  std::vector<std::string> m_group{};
-  std::map<std::string, HelpGroupDetails> m_help{};
+  const Schema& m_schema;
+  std::size_t* m_counts;
+  std::vector<std::string>& m_unmatched;
+  Convert& m_convert;
+  // The text of the value being converted, reused for every value
+  std::string m_text{};
 };
 
-class OptionAdder
+template <typename Convert>
+void
+parse
+(
+  const Schema& schema,
+  std::size_t* counts,
+  std::vector<std::string>& unmatched,
+  Convert convert,
+  int argc,
+  const char* const* argv
+)
 {
-  public:
-
-  OptionAdder(Options& options, std::string group)
-  : m_options(options), m_group(std::move(group))
-  {
-  }
-
-  OptionAdder&
-  operator()
-  (
-    const std::string& opts,
-    const std::string& desc,
-    const std::shared_ptr<const Value>& value
-      = ::cxxopts::value<bool>(),
-    std::string arg_help = ""
-  );
+  Parser<Convert>(schema, counts, unmatched, convert).parse(argc, argv);
+}
 
-  private:
-  Options& m_options;
-  std::string m_group;
-};
+} // namespace codegen
 
 namespace {
 constexpr std::size_t OPTION_LONGEST = 30;
@@ -2212,6 +5224,8 @@ constexpr std::size_t OPTION_DESC_GAP = 2;
 
 
 
+#ifdef CXXOPTS_USE_UNICODE
+
 String
 wrap_text
 (
@@ -2238,7 +5252,7 @@ wrap_text
   // Loop invariants at the beginning of each iteration:
   // 1 - [std::begin(text), startLine) is already added to result
   // 2 - currentLine [startLine, current) is not added to result yet
-  // 3 - size is the number of characters in [startLine, current)
+  // 3 - size is the display width of [startLine, current)
   //
   // At every loop we try to include current in the currentLine.
   // If there is a need to start a new line, we do that first.
@@ -2277,7 +5291,11 @@ wrap_text
     contentEnd = lineContentEnd;
     lastSpaceContentEnd = startLine;
 
-    size = std::distance(startLine, std::next(current));
+    size = 0;
+    for (auto unit = startLine; unit != std::next(current); ++unit)
+    {
+      size += unit.width();
+    }
   };
 
 
@@ -2289,72 +5307,303 @@ wrap_text
       add_line(startLine, contentEnd);
       reset_line_start(currentNext, currentNext);
 
-      // Last character is a newline. Hence there is another line to be added. An empty one
-      // And we need to do that now as we don't be doing further iterations
-      if(currentNext == textEnd) {
-        add_line(currentNext, currentNext);
+      // Last character is a newline. Hence there is another line to be added. An empty one
+      // And we need to do that now as we don't be doing further iterations
+      if(currentNext == textEnd) {
+        add_line(currentNext, currentNext);
+      }
+
+    } else {
+      size += current.width();
+      if(is_space(current)) {
+        lastSpace = current;
+        lastSpaceContentEnd = contentEnd;
+      } else {
+        contentEnd = currentNext;
+      }
+      bool endHere = false;
+      auto endLine = contentEnd;
+      auto nextLineStart = currentNext;
+
+      if(currentNext == textEnd) {
+        endHere = true;
+      }
+      else if(is_space(current) && size == 1) {
+        // Ignore leading spaces
+        reset_line_start(currentNext, currentNext);
+      }
+      else if(currentNext.width() != 0 && size + currentNext.width() > allowed
+        && !is_space(currentNext)) {
+        // currentNext does not fit. Units that take no columns, the second
+        // half of a surrogate pair or a combining mark, never start a line.
+        // Nor does a space: think of cases 'abc   \nxyz' with allowed=5,
+        // we will decide in the next iteration if needed
+        //
+        // Now we know currentNext is not a space:
+        // - if there is no breakable whitespace, we have to split the word
+        // - if the line ends in whitespace, split here
+        // - otherwise split from the last whitespace inside the line
+        if(lastSpace != startLine && lastSpace != current)
+        {
+          endLine = lastSpaceContentEnd;
+          nextLineStart = std::next(lastSpace);
+        }
+
+        // If the chosen break lands right before an explicit newline, let the
+        // newline branch handle it instead of forcing an extra wrapped line.
+        if(*endLine == '\n') {
+          endHere = false;
+        } else {
+          endHere = true;
+        }
+      }
+
+      if(endHere) {
+        add_line(startLine, endLine);
+        reset_line_start(nextLineStart, currentNext);
+      }
+    }
+  }
+
+  return result;
+}
+
+#else
+
+// Returns the first ' ', '\t', '\n' or non-ASCII byte in [first, last), or
+// last if there is none. Descriptions are scanned a block at a time where we
+// can.
+inline
+const char*
+find_space(const char* first, const char* last)
+{
+#ifdef CXXOPTS_HAS_SSE2
+  const auto space = _mm_set1_epi8(' ');
+  const auto tab = _mm_set1_epi8('\t');
+  const auto newline = _mm_set1_epi8('\n');
+
+  while (last - first >= 16)
+  {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    const auto found = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+      _mm_cmpeq_epi8(block, newline));
+    auto mask = static_cast<unsigned>(
+      _mm_movemask_epi8(found) | _mm_movemask_epi8(block));
+
+    if (mask != 0)
+    {
+      while ((mask & 1) == 0)
+      {
+        mask >>= 1;
+        ++first;
+      }
+      return first;
+    }
+
+    first += 16;
+  }
+#endif
+
+  for (; first != last; ++first)
+  {
+    if (*first == ' ' || *first == '\t' || *first == '\n' || (*first & 0x80) != 0)
+    {
+      return first;
+    }
+  }
+
+  return last;
+}
+
+// The width of the character at itr, which is not the end of the text
+inline
+std::size_t
+width_at(const char* itr, const char* last)
+{
+  if (static_cast<unsigned char>(*itr) < 0x80)
+  {
+    return 1;
+  }
+  return detail::codepoint_width(detail::utf8_decode(itr, last, itr));
+}
+
+// The same line breaking as the character by character algorithm used for
+// ICU strings, with the size of a line counted in columns. A line is broken
+// before a character that would not fit. A run of ASCII word characters is
+// skipped in one step, since where it fills the line follows from the
+// line's size.
+String
+wrap_text
+(
+  const String& text,
+  std::size_t allowed,
+  std::size_t start = 0 // spaces_to_append_at_newline
+)
+{
+  if(allowed == 0) return String{};
+
+  String result;
+  result.reserve(text.size() + text.size() / allowed * (start + 1));
+
+  const char* current = text.data();
+  const char* const textEnd = current + text.size();
+
+  const char* startLine = current;
+  const char* lastSpace = current;
+  const char* contentEnd = current;
+  const char* lastSpaceContentEnd = current;
+  auto size = std::size_t{};
+
+  bool firstLine = true;
+
+  auto add_line = [&firstLine, &result, start](const char* begin, const char* end) {
+    if(!firstLine) {
+      result += '\n';
+    }
+
+    if(begin != end) {
+      if(!firstLine) result.append(start, ' ');
+      result.append(begin, end);
+    }
+
+    firstLine = false;
+  };
+
+  // Start a line at itr that is empty up to current
+  auto reset_line_start = [&](const char* itr) {
+    startLine = itr;
+    lastSpace = startLine;
+    contentEnd = current;
+    lastSpaceContentEnd = startLine;
+
+    size = detail::display_width(startLine, current);
+  };
+
+  // Break the line before the word character at current, from the last
+  // whitespace inside the line if there is one, or else splitting the word.
+  // A break right before an explicit newline is left to the newline branch.
+  auto break_line = [&]() {
+    auto endLine = contentEnd;
+    auto nextLineStart = current;
+
+    if(lastSpace != startLine)
+    {
+      endLine = lastSpaceContentEnd;
+      nextLineStart = lastSpace + 1;
+    }
+
+    if(*endLine != '\n') {
+      add_line(startLine, endLine);
+      reset_line_start(nextLineStart);
+    }
+  };
+
+  while (current != textEnd)
+  {
+    if(*current == '\n') {
+      add_line(startLine, contentEnd);
+      ++current;
+      reset_line_start(current);
+
+      if(current == textEnd) {
+        add_line(current, current);
       }
 
-    } else {
+      continue;
+    }
+
+    if(*current == ' ' || *current == '\t') {
       size ++ ;
-      if(is_space(current)) {
-        lastSpace = current;
-        lastSpaceContentEnd = contentEnd;
-      } else {
-        contentEnd = currentNext;
-      }
-      bool endHere = false;
-      auto endLine = contentEnd;
-      auto nextLineStart = currentNext;
+      lastSpace = current;
+      lastSpaceContentEnd = contentEnd;
+      ++current;
 
-      if(currentNext == textEnd) {
-        endHere = true;
+      if(current == textEnd) {
+        add_line(startLine, contentEnd);
       }
-      else if(is_space(current) && size == 1) {
+      else if(size == 1) {
         // Ignore leading spaces
-        reset_line_start(currentNext, currentNext);
+        reset_line_start(current);
       }
-      else if(size >= allowed && !is_space(currentNext)) {
-        // Don't break. Think of cases 'abc   \nxyz' with allowed=5
-        // we will decide in the next iteration if needed
-        //
-        // Now we know currentNext is not a space:
-        // - if there is no breakable whitespace, we have to split the word
-        // - if the line ends in whitespace, split here
-        // - otherwise split from the last whitespace inside the line
-        if(lastSpace != startLine && lastSpace != current)
+      else if(*current != ' ' && *current != '\t' && *current != '\n'
+        && *contentEnd != '\n' && size + width_at(current, textEnd) > allowed) {
+        // The line ends in whitespace, split here
+        add_line(startLine, contentEnd);
+        reset_line_start(current);
+      }
+
+      continue;
+    }
+
+    // A word, which can be broken before any of its characters but the
+    // first one, or the one a break was just made before
+    bool checked = true;
+    for (;;)
+    {
+      const auto stop = find_space(current, textEnd);
+
+      while (current != stop)
+      {
+        // The ASCII characters that fit before the line is full
+        auto fits = allowed > size ? allowed - size : 0;
+        if (checked && fits == 0)
         {
-          endLine = lastSpaceContentEnd;
-          nextLineStart = std::next(lastSpace);
+          fits = 1;
         }
 
-        // If the chosen break lands right before an explicit newline, let the
-        // newline branch handle it instead of forcing an extra wrapped line.
-        if(*endLine == '\n') {
-          endHere = false;
-        } else {
-          endHere = true;
+        if (fits >= static_cast<std::size_t>(stop - current))
+        {
+          size += static_cast<std::size_t>(stop - current);
+          current = stop;
+          contentEnd = current;
+          checked = false;
+          break;
         }
+
+        size += fits;
+        current += fits;
+        contentEnd = current;
+        break_line();
+        checked = true;
       }
 
-      if(endHere) {
-        add_line(startLine, endLine);
-        reset_line_start(nextLineStart, currentNext);
+      if (current == textEnd || *current == ' ' || *current == '\t'
+        || *current == '\n')
+      {
+        break;
+      }
+
+      const auto width = width_at(current, textEnd);
+      if (!checked && size + width > allowed)
+      {
+        break_line();
       }
+      size += width;
+      detail::utf8_decode(current, textEnd, current);
+      contentEnd = current;
+      checked = false;
+    }
+
+    if(current == textEnd) {
+      add_line(startLine, contentEnd);
     }
   }
 
   return result;
 }
 
+#endif
+
 String
 format_option
 (
-  const HelpOptionDetails& o
+  const detail::HelpEntry& entry
 )
 {
-  const auto& s = o.s;
-  const auto& l = first_or_empty(o.l);
+  const std::string s = entry.option->short_name();
+  const std::string l = entry.option->first_long_name();
+  const auto& value = entry.option->value();
 
   String result = "  ";
 
@@ -2376,13 +5625,14 @@ format_option
     result += " --" + toLocalString(l);
   }
 
-  auto arg = !o.arg_help.empty() ? toLocalString(o.arg_help) : "arg";
+  auto arg = !entry.arg_help.empty() ? toLocalString(std::string(entry.arg_help))
+    : "arg";
 
-  if (!o.is_boolean)
+  if (!value.is_boolean())
   {
-    if (o.has_implicit)
+    if (value.has_implicit())
     {
-      result += " [=" + arg + "(=" + toLocalString(o.implicit_value) + ")]";
+      result += " [=" + arg + "(=" + toLocalString(value.get_implicit_value()) + ")]";
     }
     else
     {
@@ -2396,19 +5646,23 @@ format_option
 String
 format_description
 (
-  const HelpOptionDetails& o,
+  const detail::HelpEntry& entry,
   std::size_t start,
   std::size_t allowed,
   bool tab_expansion
 )
 {
-  auto desc = o.desc;
+  auto desc = entry.option->description();
+  const auto& value = entry.option->value();
+
+  const auto default_value = value.has_default() ? value.get_default_value()
+    : std::string{};
 
-  if (o.has_default && (!o.is_boolean || o.default_value != "false"))
+  if (value.has_default() && (!value.is_boolean() || default_value != "false"))
   {
-    if(!o.default_value.empty())
+    if(!default_value.empty())
     {
-      desc += toLocalString(" (default: " + o.default_value + ")");
+      desc += toLocalString(" (default: " + default_value + ")");
     }
     else
     {
@@ -2419,6 +5673,7 @@ format_description
 
   if (tab_expansion)
   {
+#ifdef CXXOPTS_USE_UNICODE
     String desc2;
     auto size = std::size_t{ 0 };
     for (auto c = std::begin(desc); c != std::end(desc); ++c)
@@ -2436,11 +5691,44 @@ format_description
       }
       else
       {
-        desc2 += *c;
-        ++size;
+        desc2.append(static_cast<UChar>(*c));
+        size += c.width();
       }
     }
     desc = desc2;
+#else
+    // Copy the text between tabs as a whole, most descriptions have none
+    auto tab = desc.find('\t');
+    if (tab != String::npos)
+    {
+      String desc2;
+      desc2.reserve(desc.size() + 8);
+      std::size_t copied = 0;
+      std::size_t column = 0;
+      auto newline = desc.find('\n');
+      while (tab != String::npos)
+      {
+        // Columns count from the last newline before the tab
+        auto line = copied;
+        while (newline < tab)
+        {
+          line = newline + 1;
+          column = 0;
+          newline = desc.find('\n', newline + 1);
+        }
+        column += detail::display_width(desc.data() + line, desc.data() + tab);
+
+        const auto skip = 8 - column % 8;
+        desc2.append(desc, copied, tab - copied);
+        desc2.append(skip, ' ');
+        column += skip;
+        copied = tab + 1;
+        tab = desc.find('\t', copied);
+      }
+      desc2.append(desc, copied, String::npos);
+      desc = std::move(desc2);
+    }
+#endif
   }
 
   return wrap_text(desc, allowed, start);
@@ -2464,6 +5752,50 @@ Options::add_options
  }
 }
 
+inline
+void
+Options::add_options
+(
+  const std::string& group,
+  const OptionSpec* first,
+  const OptionSpec* last
+)
+{
+  std::size_t name_count = 0;
+  for (auto spec = first; spec != last; ++spec)
+  {
+    name_count += spec->name_count();
+  }
+  m_options->reserve(m_options->size() + name_count);
+
+  if (m_help.find(group) == m_help.end())
+  {
+    m_group.push_back(group);
+  }
+  auto& help = m_help[group];
+  help.reserve(help.size() + static_cast<std::size_t>(last - first));
+
+  for (auto spec = first; spec != last; ++spec)
+  {
+    StringView short_name;
+    StringView long_names[OptionSpec::MAX_NAMES];
+    const auto count = spec->split_names(short_name, long_names);
+
+    auto value = spec->make_value()();
+    if (spec->default_value() != nullptr)
+    {
+      value->default_value(spec->default_value());
+    }
+    if (spec->implicit_value() != nullptr)
+    {
+      value->implicit_value(spec->implicit_value());
+    }
+
+    add_split_option(group, short_name, long_names, long_names + count,
+      spec->desc(), value, spec->arg_help());
+  }
+}
+
 inline
 OptionAdder
 Options::add_options(std::string group)
@@ -2481,34 +5813,19 @@ OptionAdder::operator()
   std::string arg_help
 )
 {
-  OptionNames option_names = values::parser_tool::split_option_names(opts);
-    // Note: All names will be non-empty; but we must separate the short
-    // (length-1) and longer names
-  std::string short_name {""};
-  auto first_short_name_iter =
-    std::stable_partition(option_names.begin(), option_names.end(),
-      [&](const std::string& name) { return name.length() > 1; }
-    );
-  auto num_length_1_names = (option_names.end() - first_short_name_iter);
-  switch(num_length_1_names) {
-  case 1:
-    short_name = *first_short_name_iter;
-    option_names.erase(first_short_name_iter);
-    CXXOPTS_FALLTHROUGH;
-  case 0:
-    break;
-  default:
-    throw_or_mimic<exceptions::invalid_option_format>(opts);
-  };
+  // The names are views of opts, so splitting them usually allocates
+  // nothing before they are copied into the options' strings
+  const values::parser_tool::SplitNames names(opts);
 
-  m_options.add_option
+  m_options.add_split_option
   (
     m_group,
-    short_name,
-    option_names,
+    names.short_name(),
+    names.begin(),
+    names.end(),
     desc,
     value,
-    std::move(arg_help)
+    arg_help
   );
 
   return *this;
@@ -2518,17 +5835,36 @@ inline
 void
 OptionParser::parse_default(const std::shared_ptr<OptionDetails>& details)
 {
+  if (m_sink != nullptr)
+  {
+    m_sink->parse_default(*details);
+    return;
+  }
+
   // TODO: remove the duplicate code here
-  auto& store = m_parsed[details->hash()];
-  store.parse_default(details);
-  m_defaults.emplace_back(details->essential_name(), details->value().get_default_value());
+  auto& store = m_result->m_values[details->index()];
+  if (defers(*details))
+  {
+    store.defer(details, OptionValue::Conversion::Default, 0);
+  }
+  else
+  {
+    store.parse_default(details);
+  }
+  record(m_result->m_defaults, m_defaults_used, details->essential_name(),
+    details->value().get_default_value().c_str());
 }
 
 inline
 void
 OptionParser::parse_no_value(const std::shared_ptr<OptionDetails>& details)
 {
-  auto& store = m_parsed[details->hash()];
+  if (m_sink != nullptr)
+  {
+    return;
+  }
+
+  auto& store = m_result->m_values[details->index()];
   store.parse_no_value(details);
 }
 
@@ -2538,14 +5874,29 @@ OptionParser::parse_option
 (
   const std::shared_ptr<OptionDetails>& value,
   const std::string& /*name*/,
-  const std::string& arg
+  const char* arg
 )
 {
-  auto hash = value->hash();
-  auto& result = m_parsed[hash];
-  result.parse(value, arg);
+  if (m_sink != nullptr)
+  {
+    ++m_counts[value->index()];
+    m_text.assign(arg);
+    m_sink->parse(*value, m_text);
+    return;
+  }
 
-  m_sequential.emplace_back(value->essential_name(), arg);
+  const auto& text = record(m_result->m_sequential, m_sequential_used,
+    value->essential_name(), arg);
+
+  auto& result = m_result->m_values[value->index()];
+  if (defers(*value))
+  {
+    result.defer(value, OptionValue::Conversion::Parse, m_sequential_used - 1);
+  }
+  else
+  {
+    result.parse(value, text);
+  }
 }
 
 inline
@@ -2563,7 +5914,7 @@ OptionParser::checked_parse_arg
   {
     if (value->value().has_implicit())
     {
-      parse_option(value, name, value->value().get_implicit_value());
+      parse_option(value, name, value->value().get_implicit_value().c_str());
     }
     else
     {
@@ -2574,7 +5925,7 @@ OptionParser::checked_parse_arg
   {
     if (value->value().has_implicit())
     {
-      parse_option(value, name, value->value().get_implicit_value());
+      parse_option(value, name, value->value().get_implicit_value().c_str());
     }
     else
     {
@@ -2585,94 +5936,311 @@ OptionParser::checked_parse_arg
 }
 
 inline
-void
-OptionParser::add_to_option(const std::shared_ptr<OptionDetails>& value, const std::string& arg)
+void
+OptionParser::add_to_option(const std::shared_ptr<OptionDetails>& value, const char* arg)
+{
+  if (m_sink != nullptr)
+  {
+    ++m_counts[value->index()];
+    m_text.assign(arg);
+    m_sink->add(*value, m_text);
+    return;
+  }
+
+  const auto& text = record(m_result->m_sequential, m_sequential_used,
+    value->essential_name(), arg);
+
+  auto& result = m_result->m_values[value->index()];
+  if (defers(*value))
+  {
+    result.defer(value, OptionValue::Conversion::Add, m_sequential_used - 1);
+  }
+  else
+  {
+    result.add(value, text);
+  }
+}
+
+inline
+const std::string&
+OptionParser::record
+(
+  std::vector<KeyValue>& list,
+  std::size_t& used,
+  StringView key,
+  const char* value
+)
+{
+  if (used < list.size())
+  {
+    list[used].assign(key, value);
+  }
+  else
+  {
+    list.emplace_back(key, value);
+  }
+
+  return list[used++].value();
+}
+
+inline
+void
+OptionParser::add_unmatched(const char* arg)
+{
+  if (m_sink != nullptr)
+  {
+    m_sink->unmatched(arg);
+    return;
+  }
+
+  auto& unmatched = m_result->m_unmatched;
+  if (m_unmatched_used < unmatched.size())
+  {
+    unmatched[m_unmatched_used].assign(arg);
+  }
+  else
+  {
+    unmatched.emplace_back(arg);
+  }
+  ++m_unmatched_used;
+}
+
+inline
+bool
+OptionParser::consume_positional(const char* a, PositionalListIterator& next)
+{
+  while (next != m_positional.end())
+  {
+    auto details = m_index->find(*next);
+    if (details != nullptr)
+    {
+      if (!(*details)->value().is_container())
+      {
+        if (count(**details) == 0)
+        {
+          add_to_option(*details, a);
+          ++next;
+          return true;
+        }
+        ++next;
+        continue;
+      }
+      add_to_option(*details, a);
+      return true;
+    }
+    throw_or_mimic<exceptions::no_such_option>(*next);
+  }
+
+  return false;
+}
+
+inline
+void
+Options::parse_positional(std::string option, PositionalMode mode)
+{
+  parse_positional(std::vector<std::string>{std::move(option)}, mode);
+}
+
+inline
+void
+Options::parse_positional(std::vector<std::string> options, PositionalMode mode)
+{
+  m_help_cache.clear();
+  switch(mode){
+    case PositionalMode::Replace:
+      m_positional = std::move(options);
+      m_positional_set = std::unordered_set<std::string>(m_positional.begin(), m_positional.end());
+      break;
+    case PositionalMode::Append:
+      m_positional.insert(m_positional.end(), options.begin(), options.end());
+      m_positional_set.insert(options.begin(), options.end());
+      break;
+  }
+}
+
+inline
+void
+Options::parse_positional(std::initializer_list<std::string> options, PositionalMode mode)
+{
+  parse_positional(std::vector<std::string>(options), mode);
+}
+
+inline
+ParseResult
+Options::parse(int argc, const char* const* argv)
+{
+  ParseResult result;
+  parse_into(result, argc, argv);
+  return result;
+}
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+inline
+ParseResult
+Options::parse(int argc, const char* const* argv, std::pmr::memory_resource* resource)
+{
+  ParseResult result(resource);
+  parse_into(result, argc, argv);
+  return result;
+}
+#endif
+
+inline
+void
+Options::parse_into(ParseResult& result, int argc, const char* const* argv)
+{
+  if (!m_index)
+  {
+    freeze();
+  }
+
+  OptionParser parser(m_index, m_positional, m_allow_unrecognised, m_lazy_conversion);
+  parser.parse_into(result, argc, argv);
+}
+
+inline
+void
+Options::parse_into(ParseSink& sink, int argc, const char* const* argv)
+{
+  if (!m_index)
+  {
+    freeze();
+  }
+
+  OptionParser parser(m_index, m_positional, m_allow_unrecognised);
+  parser.parse_into(sink, argc, argv);
+}
+
+inline
+CompiledOptions
+Options::compile()
+{
+  if (!m_index)
+  {
+    freeze();
+  }
+
+  return CompiledOptions(m_index, m_positional, m_allow_unrecognised,
+    m_lazy_conversion);
+}
+
+inline
+ParseResult
+CompiledOptions::parse(int argc, const char* const* argv) const
+{
+  ParseResult result;
+  parse_into(result, argc, argv);
+  return result;
+}
+
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+inline
+ParseResult
+CompiledOptions::parse(int argc, const char* const* argv, std::pmr::memory_resource* resource) const
 {
-  auto hash = value->hash();
-  auto& result = m_parsed[hash];
-  result.add(value, arg);
+  ParseResult result(resource);
+  parse_into(result, argc, argv);
+  return result;
+}
+#endif
 
-  m_sequential.emplace_back(value->essential_name(), arg);
+inline
+void
+CompiledOptions::parse_into(ParseResult& result, int argc, const char* const* argv) const
+{
+  OptionParser parser(m_index, m_positional, m_allow_unrecognised, m_lazy_conversion);
+  parser.parse_into(result, argc, argv);
 }
 
 inline
-bool
-OptionParser::consume_positional(const std::string& a, PositionalListIterator& next)
+void
+Options::freeze()
 {
-  while (next != m_positional.end())
+  for (const auto& schema : m_schemas)
   {
-    auto iter = m_options.find(*next);
-    if (iter != m_options.end())
+    for (std::size_t i = 0; i != schema.size(); ++i)
     {
-      if (!iter->second->value().is_container())
+      if (m_options->find(schema.name(i)) == m_options->end())
       {
-        auto& result = m_parsed[iter->second->hash()];
-        if (result.count() == 0)
-        {
-          add_to_option(iter->second, a);
-          ++next;
-          return true;
-        }
-        ++next;
-        continue;
+        throw_or_mimic<exceptions::no_such_option>(schema.name(i));
       }
-      add_to_option(iter->second, a);
-      return true;
     }
-    throw_or_mimic<exceptions::no_such_option>(*next);
   }
 
-  return false;
+  m_index = std::make_shared<const OptionIndex>(*m_options, m_schema);
 }
 
-inline
-void
-Options::parse_positional(std::string option, PositionalMode mode)
+inline ParseResult
+OptionParser::parse(int argc, const char* const* argv)
 {
-  parse_positional(std::vector<std::string>{std::move(option)}, mode);
+  ParseResult result;
+  parse_into(result, argc, argv);
+  return result;
 }
 
-inline
-void
-Options::parse_positional(std::vector<std::string> options, PositionalMode mode)
+inline void
+OptionParser::parse_into(ParseResult& result, int argc, const char* const* argv)
 {
-  switch(mode){
-    case PositionalMode::Replace:
-      m_positional = std::move(options);
-      m_positional_set = std::unordered_set<std::string>(m_positional.begin(), m_positional.end());
-      break;
-    case PositionalMode::Append:
-      m_positional.insert(m_positional.end(), options.begin(), options.end());
-      m_positional_set.insert(options.begin(), options.end());
-      break;
+  result.reset(m_index);
+  m_result = &result;
+  m_sequential_used = 0;
+  m_defaults_used = 0;
+  m_unmatched_used = 0;
+
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  try
+#endif
+  {
+    parse_arguments(argc, argv);
   }
-}
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  catch (...)
+  {
+    // don't leave half of this parse mixed with what is left of the last one
+    result.clear();
+    m_result = nullptr;
+    throw;
+  }
+#endif
 
-inline
-void
-Options::parse_positional(std::initializer_list<std::string> options, PositionalMode mode)
-{
-  parse_positional(std::vector<std::string>(options), mode);
+  // drop anything left over from an earlier parse
+  result.m_sequential.erase(result.m_sequential.begin() + m_sequential_used,
+    result.m_sequential.end());
+  result.m_defaults.erase(result.m_defaults.begin() + m_defaults_used,
+    result.m_defaults.end());
+  result.m_unmatched.erase(result.m_unmatched.begin() + m_unmatched_used,
+    result.m_unmatched.end());
+
+  if (m_lazy)
+  {
+    std::size_t pending = 0;
+    for (const auto& value : result.m_values)
+    {
+      pending += value.deferred() ? 1 : 0;
+    }
+    result.m_pending.set(pending);
+  }
+  m_result = nullptr;
 }
 
-inline
-ParseResult
-Options::parse(int argc, const char* const* argv)
+inline void
+OptionParser::parse_into(ParseSink& sink, int argc, const char* const* argv)
 {
-  OptionParser parser(*m_options, m_positional, m_allow_unrecognised);
+  m_sink = &sink;
+  m_counts.assign(m_index->options().size(), 0);
 
-  return parser.parse(argc, argv);
+  parse_arguments(argc, argv);
+
+  m_sink = nullptr;
 }
 
-inline ParseResult
-OptionParser::parse(int argc, const char* const* argv)
+inline void
+OptionParser::parse_arguments(int argc, const char* const* argv)
 {
   int current = 1;
   bool consume_remaining = false;
   auto next_positional = m_positional.begin();
 
-  std::vector<std::string> unmatched;
-
   while (current < argc)
   {
     if (strcmp(argv[current], "--") == 0)
@@ -2681,11 +6249,9 @@ OptionParser::parse(int argc, const char* const* argv)
       ++current;
       break;
     }
-    bool matched = false;
-    values::parser_tool::ArguDesc argu_desc =
-        values::parser_tool::ParseArgument(argv[current], matched);
+    values::parser_tool::ArguScan scan;
 
-    if (!matched)
+    if (!values::parser_tool::scan_argument(argv[current], scan))
     {
       //not a flag
 
@@ -2703,43 +6269,45 @@ OptionParser::parse(int argc, const char* const* argv)
       }
       else
       {
-        unmatched.emplace_back(argv[current]);
+        add_unmatched(argv[current]);
       }
       //if we return from here then it was parsed successfully, so continue
     }
     else
     {
       //short or long option?
-      if (argu_desc.grouping)
+      if (scan.grouping)
       {
-        const std::string& s = argu_desc.arg_name;
+        const char* s = scan.name;
+        const std::size_t size = scan.name_length;
 
-        for (std::size_t i = 0; i != s.size(); ++i)
+        for (std::size_t i = 0; i != size; ++i)
         {
           std::string name(1, s[i]);
-          auto iter = m_options.find(name);
+          auto details = m_index->find(s + i, 1);
 
-          if (iter == m_options.end())
+          if (details == nullptr)
           {
             if (m_allow_unrecognised)
             {
-              unmatched.push_back(std::string("-") + s[i]);
+              const char unknown[] = {'-', s[i], '\0'};
+              add_unmatched(unknown);
               continue;
             }
             //error
             throw_or_mimic<exceptions::no_such_option>(name);
           }
 
-          auto value = iter->second;
+          const auto& value = *details;
 
-          if (i + 1 == s.size())
+          if (i + 1 == size)
           {
             //it must be the last argument
-            if (argu_desc.set_value) {
+            if (scan.set_value) {
               if(value->value().has_disabled_args()){
                 throw_or_mimic<exceptions::specified_disabled_args>(name);
               }
-              parse_option(value, name, argu_desc.value);
+              parse_option(value, name, scan.value);
             }
             else{
               checked_parse_arg(argc, argv, current, value, name);
@@ -2747,12 +6315,12 @@ OptionParser::parse(int argc, const char* const* argv)
           }
           else if (value->value().has_implicit())
           {
-            parse_option(value, name, value->value().get_implicit_value());
+            parse_option(value, name, value->value().get_implicit_value().c_str());
           }
-          else if (i + 1 < s.size())
+          else if (i + 1 < size)
           {
-            std::string arg_value = s.substr(i + 1);
-            parse_option(value, name, arg_value);
+            // the rest of the group is the value
+            parse_option(value, name, s + i + 1);
             break;
           }
           else
@@ -2762,18 +6330,18 @@ OptionParser::parse(int argc, const char* const* argv)
           }
         }
       }
-      else if (argu_desc.arg_name.length() != 0)
+      else
       {
-        const std::string& name = argu_desc.arg_name;
+        const std::string name(scan.name, scan.name_length);
 
-        auto iter = m_options.find(name);
+        auto details = m_index->find(scan.name, scan.name_length);
 
-        if (iter == m_options.end())
+        if (details == nullptr)
         {
           if (m_allow_unrecognised)
           {
             // keep unrecognised options in argument list, skip to next argument
-            unmatched.emplace_back(argv[current]);
+            add_unmatched(argv[current]);
             ++current;
             continue;
           }
@@ -2781,17 +6349,17 @@ OptionParser::parse(int argc, const char* const* argv)
           throw_or_mimic<exceptions::no_such_option>(name);
         }
 
-        auto opt = iter->second;
+        const auto& opt = *details;
 
         //equals provided for long option?
-        if (argu_desc.set_value)
+        if (scan.set_value)
         {
           if(opt->value().has_disabled_args()){
             throw_or_mimic<exceptions::specified_disabled_args>(name);
           }
           //parse the option given
 
-          parse_option(opt, name, argu_desc.value);
+          parse_option(opt, name, scan.value);
         }
         else
         {
@@ -2805,15 +6373,18 @@ OptionParser::parse(int argc, const char* const* argv)
     ++current;
   }
 
-  for (auto& opt : m_options)
+  for (const auto& detail : m_index->options())
   {
-    auto& detail = opt.second;
-    const auto& value = detail->value();
+    if (!detail)
+    {
+      // an option that failed to be added
+      continue;
+    }
 
-    auto& store = m_parsed[detail->hash()];
+    const auto& value = detail->value();
 
     if (value.has_default()) {
-      if (!store.count() && !store.has_default()) {
+      if (count(*detail) == 0) {
         parse_default(detail);
       }
     }
@@ -2834,43 +6405,43 @@ OptionParser::parse(int argc, const char* const* argv)
 
     //adjust argv for any that couldn't be swallowed
     while (current != argc) {
-      unmatched.emplace_back(argv[current]);
+      add_unmatched(argv[current]);
       ++current;
     }
   }
-
-  finalise_aliases();
-
-  ParseResult parsed(std::move(m_keys), std::move(m_parsed), std::move(m_sequential), std::move(m_defaults), std::move(unmatched));
-  return parsed;
 }
 
 inline
 void
-OptionParser::finalise_aliases()
+Options::add_option
+(
+  const std::string& group,
+  const Option& option
+)
 {
-  for (auto& option: m_options)
-  {
-    auto& detail = *option.second;
-    auto hash = detail.hash();
-    m_keys[detail.short_name()] = hash;
-    for(const auto& long_name : detail.long_names()) {
-      m_keys[long_name] = hash;
-    }
-
-    m_parsed.emplace(hash, OptionValue());
-  }
+    add_options(group, {option});
 }
 
-inline
-void
+template <typename T>
+OptionHandle<T>
 Options::add_option
 (
   const std::string& group,
-  const Option& option
+  const std::string& opts,
+  const std::string& desc,
+  const std::shared_ptr<const Value>& value,
+  std::string arg_help
 )
 {
-    add_options(group, {option});
+#ifndef CXXOPTS_NO_RTTI
+  if (dynamic_cast<const values::standard_value<T>*>(value.get()) == nullptr)
+  {
+    throw_or_mimic<exceptions::option_handle_type_mismatch>(opts);
+  }
+#endif
+
+  add_options(group)(opts, desc, value, std::move(arg_help));
+  return OptionHandle<T>(*m_option_count - 1, m_schema);
 }
 
 inline
@@ -2885,17 +6456,51 @@ Options::add_option
   std::string arg_help
 )
 {
-  auto stringDesc = toLocalString(std::move(desc));
-  auto option = std::make_shared<OptionDetails>(s, l, stringDesc, value);
+  add_split_option(group, s, l.begin(), l.end(), desc, value, arg_help);
+}
+
+template <typename Iterator>
+void
+Options::add_split_option
+(
+  const std::string& group,
+  StringView s,
+  Iterator first,
+  Iterator last,
+  StringView desc,
+  const std::shared_ptr<const Value>& value,
+  StringView arg_help
+)
+{
+  m_help_cache.clear();
+  auto option = std::make_shared<OptionDetails>(m_strings, s, first, last,
+    desc, value, *m_option_count);
 
   if (!s.empty())
   {
-    add_one_option(s, option);
+    add_one_option(option->short_name(), option);
   }
 
-  for(const auto& long_name : l) {
-    add_one_option(long_name, option);
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  try
+#endif
+  {
+    for (const auto& long_name : option->long_names())
+    {
+      add_one_option(long_name, option);
+    }
+  }
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  catch (...)
+  {
+    // take back the names already added, so the index is not used twice
+    remove_option_names(option);
+    throw;
   }
+#endif
+
+  // the index is only taken once every name is in
+  ++*m_option_count;
 
   //add the help details
 
@@ -2904,174 +6509,356 @@ Options::add_option
     m_group.push_back(group);
   }
 
-  auto& options = m_help[group];
+  auto& help = m_help[group];
+  help.emplace_back(detail::HelpEntry{option, m_strings->add(arg_help)});
+  m_help_cache.add_to_group(group, help.back());
+}
+
+inline
+void
+Options::remove_option_names(const std::shared_ptr<OptionDetails>& details)
+{
+  auto remove = [&](StringView name) {
+    auto iter = m_options->find(name);
+    if (iter != m_options->end() && iter->second == details)
+    {
+      m_options->erase(iter);
+    }
+  };
 
-  options.options.emplace_back(HelpOptionDetails{s, l, stringDesc,
-      value->has_default(), value->get_default_value(),
-      value->has_implicit(), value->get_implicit_value(),
-      std::move(arg_help),
-      value->is_container(),
-      value->is_boolean()});
+  if (!details->short_name().empty())
+  {
+    remove(details->short_name());
+  }
+  for (const auto& long_name : details->long_names())
+  {
+    remove(long_name);
+  }
 }
 
 inline
 void
 Options::add_one_option
 (
-  const std::string& option,
+  StringView option,
   const std::shared_ptr<OptionDetails>& details
 )
 {
-  auto in = m_options->emplace(option, details);
+  auto in = m_options->emplace(std::string(option), details);
 
   if (!in.second)
   {
     throw_or_mimic<exceptions::option_already_exists>(option);
   }
+
+  m_index.reset();
 }
 
 inline
-String
-Options::help_one_group(const std::string& g) const
+OptionIndex::OptionIndex(const OptionMap& options, std::uint64_t schema)
+: m_schema(schema)
 {
-  using OptionHelp = std::vector<std::pair<String, String>>;
+  std::vector<std::uint64_t> hashes;
+  hashes.reserve(options.size());
+  m_entries.reserve(options.size());
 
-  String result;
+  std::size_t total_length = 0;
+  for (const auto& option : options)
+  {
+    total_length += option.first.size();
+  }
+  m_names.reserve(total_length);
 
-  auto group = m_help.find(g);
-  if (group == m_help.end())
+  for (const auto& option : options)
   {
-    return result;
+    const auto& name = option.first;
+    m_entries.push_back(Entry{m_names.size(), name.size(), option.second});
+    m_names += name;
+    hashes.push_back(detail::hash_name(name.data(), name.size()));
+
+    const auto index = option.second->index();
+    if (index >= m_options.size())
+    {
+      m_options.resize(index + 1);
+    }
+    m_options[index] = option.second;
   }
 
-  OptionHelp format;
+  if (m_hash.build(hashes))
+  {
+    return;
+  }
 
-  std::size_t longest = 0;
+  // Two names share a hash, so look names up by binary search instead
+  m_by_hash.reserve(hashes.size());
+  for (std::size_t i = 0; i != hashes.size(); ++i)
+  {
+    m_by_hash.emplace_back(hashes[i], i);
+  }
+  std::sort(m_by_hash.begin(), m_by_hash.end());
+}
 
-  if (!g.empty())
+inline
+bool
+detail::PerfectHash::build(const std::vector<std::uint64_t>& hashes)
+{
+  if (hashes.empty())
+  {
+    return true;
+  }
+
+  auto sorted = hashes;
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
   {
-    result += toLocalString(" " + g + " options:\n");
+    return false;
   }
 
-  for (const auto& o : group->second.options)
+  // Start with a table at most half full, and grow it in the unlikely case
+  // that no displacement can be found for some bucket.
+  std::size_t slot_count = 2;
+  while (slot_count < 2 * hashes.size())
+  {
+    slot_count *= 2;
+  }
+  const auto max_slot_count = slot_count * 64;
+  while (!place(hashes, slot_count))
   {
-    if (o.l.size() &&
-        m_positional_set.find(o.l.front()) != m_positional_set.end() &&
-        !m_show_positional)
+    slot_count *= 2;
+    if (slot_count > max_slot_count)
     {
-      continue;
+      m_displacements.clear();
+      m_slots.clear();
+      return false;
     }
+  }
+  return true;
+}
+
+// Hash and displace: the names are split into buckets by their hash, then
+// starting with the largest bucket, each bucket searches for a displacement
+// that moves all of its names into free slots.
+inline
+bool
+detail::PerfectHash::place(const std::vector<std::uint64_t>& hashes, std::size_t slot_count)
+{
+  std::size_t bucket_count = 1;
+  while (bucket_count * 2 < hashes.size())
+  {
+    bucket_count *= 2;
+  }
+  m_bucket_mask = bucket_count - 1;
+  m_slot_mask = slot_count - 1;
 
-    auto s = format_option(o);
-    longest = (std::max)(longest, stringLength(s));
-    format.push_back(std::make_pair(s, String()));
+  std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+  for (std::size_t i = 0; i != hashes.size(); ++i)
+  {
+    buckets[hashes[i] & m_bucket_mask].push_back(static_cast<std::uint32_t>(i));
   }
-  longest = (std::min)(longest, OPTION_LONGEST);
 
-  //widest allowed description -- min 10 chars for helptext/line
-  std::size_t allowed = 10;
-  if (m_width > allowed + longest + OPTION_DESC_GAP)
+  std::vector<std::size_t> order(bucket_count);
+  for (std::size_t i = 0; i != bucket_count; ++i)
   {
-    allowed = m_width - longest - OPTION_DESC_GAP;
+    order[i] = i;
   }
+  std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  m_displacements.assign(bucket_count, 0);
+  m_slots.assign(slot_count, 0);
 
-  auto fiter = format.begin();
-  for (const auto& o : group->second.options)
+  constexpr std::uint32_t max_displacement = 1u << 16;
+  std::vector<std::size_t> chosen;
+  for (auto bucket : order)
   {
-    if (o.l.size() &&
-        m_positional_set.find(o.l.front()) != m_positional_set.end() &&
-        !m_show_positional)
+    const auto& members = buckets[bucket];
+    if (members.empty())
     {
-      continue;
+      break;
     }
 
-    auto d = format_description(o, longest + OPTION_DESC_GAP, allowed, m_tab_expansion);
+    std::uint32_t displacement = 0;
+    for (; displacement != max_displacement; ++displacement)
+    {
+      chosen.clear();
+      for (auto member : members)
+      {
+        const auto slot = static_cast<std::size_t>(
+          displace_hash(hashes[member], displacement) & m_slot_mask);
+        if (m_slots[slot] != 0 ||
+            std::find(chosen.begin(), chosen.end(), slot) != chosen.end())
+        {
+          break;
+        }
+        chosen.push_back(slot);
+      }
 
-    result += fiter->first;
+      if (chosen.size() == members.size())
+      {
+        break;
+      }
+    }
 
-    if (stringLength(fiter->first) > longest)
+    if (displacement == max_displacement)
     {
-      result += '\n';
-      result += toLocalString(std::string(longest + OPTION_DESC_GAP, ' '));
+      return false;
     }
-    else
+
+    m_displacements[bucket] = displacement;
+    for (std::size_t i = 0; i != members.size(); ++i)
     {
-      result += toLocalString(std::string(longest + OPTION_DESC_GAP -
-        stringLength(fiter->first),
-        ' '));
+      m_slots[chosen[i]] = members[i] + 1;
     }
-    result += d;
-    result += '\n';
-
-    ++fiter;
   }
 
-  return result;
+  return true;
 }
 
 inline
-void
-Options::generate_group_help
-(
-  String& result,
-  const std::vector<std::string>& print_groups
-) const
+bool
+Options::visible_in_help(const detail::HelpEntry& entry) const
 {
-  for (std::size_t i = 0; i != print_groups.size(); ++i)
+  const auto& l = entry.option->long_names();
+  return m_show_positional || l.empty() ||
+    m_positional_set.find(l.front()) == m_positional_set.end();
+}
+
+// Options are formatted in two passes, the first to find the widest names,
+// so that only one option is held at a time.
+inline
+bool
+Options::write_group_help(const std::string& g, detail::HelpWriter& out) const
+{
+  auto group = m_help.find(g);
+  if (group == m_help.end())
+  {
+    return false;
+  }
+
+  std::size_t longest = 0;
+  bool any_visible = false;
+  for (const auto& o : group->second)
+  {
+    if (visible_in_help(o))
+    {
+      any_visible = true;
+      longest = (std::max)(longest, stringLength(format_option(o)));
+    }
+  }
+  if (g.empty() && !any_visible)
+  {
+    return false;
+  }
+  longest = (std::min)(longest, OPTION_LONGEST);
+
+  //widest allowed description -- min 10 chars for helptext/line
+  std::size_t allowed = 10;
+  if (m_width > allowed + longest + OPTION_DESC_GAP)
+  {
+    allowed = m_width - longest - OPTION_DESC_GAP;
+  }
+
+  if (!g.empty())
+  {
+    out.write(toLocalString(" " + g + " options:\n"));
+  }
+
+  String line;
+  for (const auto& o : group->second)
   {
-    const String& group_help_text = help_one_group(print_groups[i]);
-    if (empty(group_help_text))
+    if (!visible_in_help(o))
     {
       continue;
     }
-    result += group_help_text;
-    if (i < print_groups.size() - 1)
+
+    line = format_option(o);
+    const auto length = stringLength(line);
+    if (length > longest)
     {
-      result += '\n';
+      line += '\n';
+      line += toLocalString(std::string(longest + OPTION_DESC_GAP, ' '));
     }
+    else
+    {
+      line += toLocalString(std::string(longest + OPTION_DESC_GAP - length, ' '));
+    }
+    line += format_description(o, longest + OPTION_DESC_GAP, allowed, m_tab_expansion);
+    line += '\n';
+    out.write(line);
   }
-}
 
-inline
-void
-Options::generate_all_groups_help(String& result) const
-{
-  generate_group_help(result, m_group);
+  return true;
 }
 
 inline
-std::string
-Options::help(const std::vector<std::string>& help_groups, bool print_usage) const
+void
+Options::write_help
+(
+  detail::HelpWriter& out,
+  const std::vector<std::string>& help_groups,
+  bool print_usage
+) const
 {
-  String result = m_help_string;
+  String usage = m_help_string;
   if(print_usage)
   {
-    result+= "\nUsage:\n  " + toLocalString(m_program);
+    usage += "\nUsage:\n  " + toLocalString(m_program);
   }
 
   if (!m_custom_help.empty())
   {
-    result += " " + toLocalString(m_custom_help);
+    usage += " " + toLocalString(m_custom_help);
   }
 
   if (!m_positional.empty() && !m_positional_help.empty()) {
-    result += " " + toLocalString(m_positional_help);
+    usage += " " + toLocalString(m_positional_help);
   }
 
-  result += "\n\n";
+  usage += "\n\n";
 
-  result = wrap_text(result, m_width, 0);
+  out.write(wrap_text(usage, m_width, 0));
 
-  if (help_groups.empty())
+  const auto& groups = help_groups.empty() ? m_group : help_groups;
+  for (std::size_t i = 0; i != groups.size(); ++i)
   {
-    generate_all_groups_help(result);
+    if (write_group_help(groups[i], out) && i < groups.size() - 1)
+    {
+      out.write(toLocalString("\n"));
+    }
   }
-  else
+}
+
+inline
+std::string
+Options::help(const std::vector<std::string>& help_groups, bool print_usage) const
+{
+  std::string cached;
+  if (m_help_cache.find(help_groups, print_usage, cached))
   {
-    generate_group_help(result, help_groups);
+    return cached;
   }
 
-  return toUTF8String(result);
+  String result;
+  detail::HelpWriter out(result);
+  write_help(out, help_groups, print_usage);
+
+  auto help = toUTF8String(result);
+  m_help_cache.insert(help_groups, print_usage, help);
+  return help;
+}
+
+inline
+void
+Options::help_to
+(
+  std::ostream& out,
+  const std::vector<std::string>& help_groups,
+  bool print_usage
+) const
+{
+  detail::HelpWriter writer(out);
+  write_help(writer, help_groups, print_usage);
 }
 
 inline
@@ -3085,7 +6872,14 @@ inline
 const HelpGroupDetails&
 Options::group_help(const std::string& group) const
 {
-  return m_help.at(group);
+  const auto& entries = m_help.at(group);
+  return m_help_cache.group(group, [&](HelpGroupDetails& details) {
+    details.options.reserve(entries.size());
+    for (const auto& entry : entries)
+    {
+      details.options.push_back(detail::help_details(entry));
+    }
+  });
 }
 
 } // namespace cxxopts
@@ -0,0 +1,948 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+// cxxopts-codegen: writes a header with a typed parser for a file of option
+// specs. Each line of the file is a keyword and its arguments, separated by
+// spaces. An argument may be quoted with "", inside which \" and \\ are
+// escapes, and # starts a comment:
+//
+//   program NAME "description"   the program, for the help text
+//   namespace NAME               where the generated code goes
+//   struct NAME                  the struct holding the options, Config
+//   width N                      the width of the help text
+//   custom_help "text"           as Options::custom_help
+//   positional_help "text"       as Options::positional_help
+//   show_positional_help         as Options::show_positional_help
+//   allow_unrecognised           as Options::allow_unrecognised_options
+//   positional NAME...           as Options::parse_positional
+//   group NAME                   the group of the options that follow
+//   option NAMES TYPE "description" [key=value]...
+//
+// The keys of an option are default, implicit, arg (the argument help),
+// member (the name of its member, the first long name otherwise), and
+// delimiter and quote for lists. TYPE is bool, char, string, float, double,
+// int, unsigned, long, int8 to int64, uint8 to uint64, or vector<TYPE>.
+//
+// The header holds the struct, with one member per option, a parse function
+// converting the arguments straight into it, the help text, and an options
+// function making the same options as a cxxopts::Options. The help text is
+// rendered by the generator, for the width in the spec or given with
+// --width, so printing it costs a single write.
+
+#include "cxxopts.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+struct Type
+{
+  std::string cpp;
+  std::shared_ptr<cxxopts::Value> (*make)();
+};
+
+template <typename T>
+std::shared_ptr<cxxopts::Value>
+make_value()
+{
+  return cxxopts::value<T>();
+}
+
+template <typename T>
+void
+add_type(std::map<std::string, Type>& types, const std::string& name, const std::string& cpp)
+{
+  types.emplace(name, Type{cpp, &make_value<T>});
+  types.emplace("vector<" + name + ">",
+    Type{"std::vector<" + cpp + ">", &make_value<std::vector<T>>});
+}
+
+const std::map<std::string, Type>&
+types()
+{
+  static const std::map<std::string, Type> all = [] {
+    std::map<std::string, Type> t;
+    add_type<bool>(t, "bool", "bool");
+    add_type<char>(t, "char", "char");
+    add_type<std::string>(t, "string", "std::string");
+    add_type<float>(t, "float", "float");
+    add_type<double>(t, "double", "double");
+    add_type<int>(t, "int", "int");
+    add_type<unsigned>(t, "unsigned", "unsigned");
+    add_type<long>(t, "long", "long");
+    add_type<std::int8_t>(t, "int8", "std::int8_t");
+    add_type<std::int16_t>(t, "int16", "std::int16_t");
+    add_type<std::int32_t>(t, "int32", "std::int32_t");
+    add_type<std::int64_t>(t, "int64", "std::int64_t");
+    add_type<std::uint8_t>(t, "uint8", "std::uint8_t");
+    add_type<std::uint16_t>(t, "uint16", "std::uint16_t");
+    add_type<std::uint32_t>(t, "uint32", "std::uint32_t");
+    add_type<std::uint64_t>(t, "uint64", "std::uint64_t");
+    return t;
+  }();
+  return all;
+}
+
+struct OptionSpec
+{
+  int line = 0;
+  std::string group{};
+  std::string opts{};
+  std::string type{};
+  std::string desc{};
+  std::string member{};
+  std::string arg_help{};
+  std::shared_ptr<cxxopts::Value> value{};
+  bool has_default = false;
+  std::string default_value{};
+  bool has_implicit = false;
+  std::string implicit_value{};
+  bool has_delimiter = false;
+  char delimiter = CXXOPTS_VECTOR_DELIMITER;
+  char quote = '\0';
+  // The short name first, if there is one
+  std::vector<std::string> names{};
+};
+
+struct Spec
+{
+  std::string program = "program";
+  std::string description{};
+  std::string name_space{};
+  std::string struct_name = "Config";
+  std::size_t width = 76;
+  bool has_custom_help = false;
+  std::string custom_help{};
+  bool has_positional_help = false;
+  std::string positional_help{};
+  bool show_positional_help = false;
+  bool allow_unrecognised = false;
+  std::vector<std::string> positional{};
+  std::vector<OptionSpec> options{};
+};
+
+class SpecError : public std::runtime_error
+{
+  public:
+  SpecError(int line, const std::string& message)
+  : std::runtime_error(std::to_string(line) + ": " + message)
+  {
+  }
+};
+
+// Splits a line into its arguments
+std::vector<std::string>
+split_words(const std::string& line, int number)
+{
+  std::vector<std::string> words;
+  auto i = line.begin();
+  while (true)
+  {
+    while (i != line.end() && (*i == ' ' || *i == '\t' || *i == '\r'))
+    {
+      ++i;
+    }
+    if (i == line.end() || *i == '#')
+    {
+      return words;
+    }
+
+    std::string word;
+    while (i != line.end() && *i != ' ' && *i != '\t' && *i != '\r')
+    {
+      if (*i != '"')
+      {
+        word += *i++;
+        continue;
+      }
+
+      for (++i; i != line.end() && *i != '"'; ++i)
+      {
+        if (*i == '\\' && i + 1 != line.end())
+        {
+          ++i;
+        }
+        word += *i;
+      }
+      if (i == line.end())
+      {
+        throw SpecError(number, "unterminated quote");
+      }
+      ++i;
+    }
+    words.push_back(std::move(word));
+  }
+}
+
+bool
+is_identifier(const std::string& name)
+{
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+  {
+    return false;
+  }
+  for (auto c : name)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Names that are valid identifiers, but cannot name a member or a struct
+bool
+is_keyword(const std::string& name)
+{
+  static const char* const keywords[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+    "bool", "break", "case", "catch", "char", "char8_t", "char16_t",
+    "char32_t", "class", "compl", "concept", "const", "consteval",
+    "constexpr", "constinit", "const_cast", "continue", "co_await",
+    "co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+    "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+    "operator", "or", "or_eq", "private", "protected", "public", "register",
+    "reinterpret_cast", "requires", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "static_cast", "struct", "switch", "template",
+    "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+  };
+
+  for (const auto* keyword : keywords)
+  {
+    if (name == keyword)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t
+read_width(const std::string& text, int number)
+{
+  const auto digits = !text.empty() && std::all_of(text.begin(), text.end(),
+    [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+  if (digits)
+  {
+    try
+    {
+      return static_cast<std::size_t>(std::stoul(text));
+    }
+    catch (const std::out_of_range&)
+    {
+    }
+  }
+  throw SpecError(number, "expected a width in columns, not '" + text + "'");
+}
+
+char
+single_char(const std::string& text, int number)
+{
+  if (text.size() != 1)
+  {
+    throw SpecError(number, "expected a single character, not '" + text + "'");
+  }
+  return text[0];
+}
+
+OptionSpec
+read_option(const std::vector<std::string>& words, const std::string& group, int number)
+{
+  if (words.size() < 4)
+  {
+    throw SpecError(number, "expected option NAMES TYPE \"description\"");
+  }
+
+  OptionSpec option;
+  option.line = number;
+  option.group = group;
+  option.opts = words[1];
+  option.type = words[2];
+  option.desc = words[3];
+
+  const auto type = types().find(option.type);
+  if (type == types().end())
+  {
+    throw SpecError(number, "unknown type '" + option.type + "'");
+  }
+  option.value = type->second.make();
+
+  for (auto i = words.begin() + 4; i != words.end(); ++i)
+  {
+    const auto equals = i->find('=');
+    if (equals == std::string::npos)
+    {
+      throw SpecError(number, "expected key=value, not '" + *i + "'");
+    }
+
+    const auto key = i->substr(0, equals);
+    const auto text = i->substr(equals + 1);
+    if (key == "default")
+    {
+      option.has_default = true;
+      option.default_value = text;
+      option.value->default_value(text);
+    }
+    else if (key == "implicit")
+    {
+      option.has_implicit = true;
+      option.implicit_value = text;
+      option.value->implicit_value(text);
+    }
+    else if (key == "arg")
+    {
+      option.arg_help = text;
+    }
+    else if (key == "member")
+    {
+      option.member = text;
+    }
+    else if (key == "delimiter" || key == "quote")
+    {
+      if (!option.value->is_container())
+      {
+        throw SpecError(number, key + " is only for vector types");
+      }
+      option.has_delimiter = true;
+      (key == "delimiter" ? option.delimiter : option.quote) = single_char(text, number);
+      option.value->delimiter(option.delimiter, option.quote);
+    }
+    else
+    {
+      throw SpecError(number, "unknown key '" + key + "'");
+    }
+  }
+
+  cxxopts::OptionNames names;
+  try
+  {
+    names = cxxopts::values::parser_tool::split_option_names(option.opts);
+  }
+  catch (const cxxopts::exceptions::exception& e)
+  {
+    throw SpecError(number, e.what());
+  }
+
+  for (auto& name : names)
+  {
+    if (name.size() == 1)
+    {
+      option.names.insert(option.names.begin(), name);
+    }
+    else
+    {
+      option.names.push_back(name);
+    }
+  }
+
+  if (option.member.empty())
+  {
+    for (const auto& name : option.names)
+    {
+      if (name.size() != 1)
+      {
+        option.member = name;
+        std::replace(option.member.begin(), option.member.end(), '-', '_');
+        break;
+      }
+    }
+  }
+  if (!is_identifier(option.member))
+  {
+    throw SpecError(number, option.member.empty()
+      ? "an option with only a short name needs a member"
+      : "'" + option.member + "' is not a valid member name");
+  }
+  if (is_keyword(option.member))
+  {
+    throw SpecError(number, "the member name '" + option.member +
+      "' is a C++ keyword, choose one with member=");
+  }
+
+  return option;
+}
+
+Spec
+read_spec(std::istream& in)
+{
+  Spec spec;
+  std::string group;
+  std::string line;
+  int number = 0;
+  int struct_line = 0;
+  while (std::getline(in, line))
+  {
+    ++number;
+    const auto words = split_words(line, number);
+    if (words.empty())
+    {
+      continue;
+    }
+
+    const auto& keyword = words[0];
+    const auto argument = [&](std::size_t i) -> const std::string& {
+      if (i >= words.size())
+      {
+        throw SpecError(number, keyword + " needs an argument");
+      }
+      return words[i];
+    };
+
+    if (keyword == "option")
+    {
+      spec.options.push_back(read_option(words, group, number));
+    }
+    else if (keyword == "program")
+    {
+      spec.program = argument(1);
+      spec.description = words.size() > 2 ? words[2] : "";
+    }
+    else if (keyword == "namespace")
+    {
+      spec.name_space = argument(1);
+    }
+    else if (keyword == "struct")
+    {
+      spec.struct_name = argument(1);
+      struct_line = number;
+    }
+    else if (keyword == "width")
+    {
+      spec.width = read_width(argument(1), number);
+    }
+    else if (keyword == "custom_help")
+    {
+      spec.has_custom_help = true;
+      spec.custom_help = argument(1);
+    }
+    else if (keyword == "positional_help")
+    {
+      spec.has_positional_help = true;
+      spec.positional_help = argument(1);
+    }
+    else if (keyword == "show_positional_help")
+    {
+      spec.show_positional_help = true;
+    }
+    else if (keyword == "allow_unrecognised")
+    {
+      spec.allow_unrecognised = true;
+    }
+    else if (keyword == "positional")
+    {
+      spec.positional.insert(spec.positional.end(), words.begin() + 1, words.end());
+    }
+    else if (keyword == "group")
+    {
+      group = words.size() > 1 ? words[1] : "";
+    }
+    else
+    {
+      throw SpecError(number, "unknown keyword '" + keyword + "'");
+    }
+  }
+
+  if (spec.options.empty())
+  {
+    throw SpecError(number, "no options");
+  }
+  if (!is_identifier(spec.struct_name) || is_keyword(spec.struct_name))
+  {
+    throw SpecError(struct_line == 0 ? number : struct_line,
+      "'" + spec.struct_name + "' is not a valid struct name");
+  }
+
+  for (std::size_t i = 0; i != spec.options.size(); ++i)
+  {
+    const auto& member = spec.options[i].member;
+    if (member == "counts" || member == "unmatched" || member == "count")
+    {
+      throw SpecError(spec.options[i].line, "the member name '" + member + "' is reserved");
+    }
+    for (std::size_t j = 0; j != i; ++j)
+    {
+      if (spec.options[j].member == member)
+      {
+        throw SpecError(spec.options[i].line, "the member '" + member + "' already exists");
+      }
+    }
+  }
+
+  return spec;
+}
+
+// The option a name belongs to
+std::size_t
+find_option(const Spec& spec, const std::string& name)
+{
+  for (std::size_t i = 0; i != spec.options.size(); ++i)
+  {
+    const auto& names = spec.options[i].names;
+    if (std::find(names.begin(), names.end(), name) != names.end())
+    {
+      return i;
+    }
+  }
+  throw std::runtime_error("positional option '" + name + "' does not exist");
+}
+
+// The options as cxxopts::Options, which also checks the names
+cxxopts::Options
+make_options(const Spec& spec)
+{
+  cxxopts::Options options(spec.program, spec.description);
+  options.set_width(spec.width);
+  if (spec.has_custom_help)
+  {
+    options.custom_help(spec.custom_help);
+  }
+  if (spec.has_positional_help)
+  {
+    options.positional_help(spec.positional_help);
+  }
+  if (spec.show_positional_help)
+  {
+    options.show_positional_help();
+  }
+
+  for (const auto& option : spec.options)
+  {
+    try
+    {
+      options.add_options(option.group)
+        (option.opts, option.desc, option.value, option.arg_help);
+    }
+    catch (const cxxopts::exceptions::exception& e)
+    {
+      throw SpecError(option.line, e.what());
+    }
+  }
+  if (!spec.positional.empty())
+  {
+    options.parse_positional(spec.positional);
+  }
+  return options;
+}
+
+std::string
+escape(const std::string& text)
+{
+  std::string escaped;
+  for (auto c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+      escaped += c;
+    }
+    else if (c == '\n')
+    {
+      escaped += "\\n";
+    }
+    else if (c == '\t')
+    {
+      escaped += "\\t";
+    }
+    else if (static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7f)
+    {
+      // always three digits, so that a following digit is not part of it
+      const auto u = static_cast<unsigned char>(c);
+      escaped += '\\';
+      escaped += static_cast<char>('0' + (u >> 6));
+      escaped += static_cast<char>('0' + ((u >> 3) & 7));
+      escaped += static_cast<char>('0' + (u & 7));
+    }
+    else
+    {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string
+literal(const std::string& text)
+{
+  return "\"" + escape(text) + "\"";
+}
+
+std::string
+char_literal(char c)
+{
+  if (c == '\'')
+  {
+    return "'\\''";
+  }
+  if (c == '"')
+  {
+    return "'\"'";
+  }
+  return c == '\0' ? "'\\0'" : "'" + escape(std::string(1, c)) + "'";
+}
+
+std::string
+list_format(const OptionSpec& option)
+{
+  return "cxxopts::values::ListFormat(" + char_literal(option.delimiter) + ", " +
+    char_literal(option.quote) + ")";
+}
+
+template <typename T>
+void
+write_list(std::ostream& out, const std::vector<T>& values)
+{
+  for (std::size_t i = 0; i != values.size(); ++i)
+  {
+    out << (i % 8 == 0 ? "\n    " : " ") << values[i] << (i + 1 == values.size() ? "" : ",");
+  }
+  out << "\n  };\n";
+}
+
+void
+write_header(std::ostream& out, const Spec& spec, const std::string& source)
+{
+  auto options = make_options(spec);
+  std::vector<std::size_t> positional;
+  for (const auto& name : spec.positional)
+  {
+    positional.push_back(find_option(spec, name));
+  }
+
+  std::string names;
+  std::vector<std::string> entries;
+  std::vector<std::uint64_t> hashes;
+  for (std::size_t i = 0; i != spec.options.size(); ++i)
+  {
+    for (const auto& name : spec.options[i].names)
+    {
+      entries.push_back("{" + std::to_string(names.size()) + ", " +
+        std::to_string(name.size()) + ", " + std::to_string(i) + "}");
+      hashes.push_back(cxxopts::detail::hash_name(name.data(), name.size()));
+      names += name;
+    }
+  }
+  cxxopts::detail::PerfectHash hash;
+  if (!hash.build(hashes))
+  {
+    // The generated lookup has no fallback, so the names must hash apart
+    throw std::runtime_error("option names cannot be perfectly hashed, "
+      "two of them have the same hash");
+  }
+
+  auto guard = "CXXOPTS_GENERATED_" + spec.name_space + "_" + spec.struct_name + "_HPP";
+  std::replace(guard.begin(), guard.end(), ':', '_');
+  std::transform(guard.begin(), guard.end(), guard.begin(), [](char c) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  });
+
+  bool has_lists = false;
+  for (const auto& option : spec.options)
+  {
+    has_lists = has_lists || option.value->is_container();
+  }
+
+  out << "// Generated by cxxopts-codegen from " << source << ", do not edit.\n\n"
+      << "#ifndef " << guard << "\n"
+      << "#define " << guard << "\n\n"
+      << "#include <array>\n"
+      << "#include <cstddef>\n"
+      << "#include <cstdint>\n"
+      << "#include <cstdio>\n"
+      << "#include <string>\n"
+      << "#include <vector>\n\n"
+      << "#include \"cxxopts.hpp\"\n\n";
+  if (!spec.name_space.empty())
+  {
+    out << "namespace " << spec.name_space << " {\n\n";
+  }
+
+  out << "enum class Option : std::size_t\n{\n";
+  for (const auto& option : spec.options)
+  {
+    out << "  " << option.member << ",\n";
+  }
+  out << "};\n\n";
+
+  out << "struct " << spec.struct_name << "\n{\n";
+  for (const auto& option : spec.options)
+  {
+    out << "  " << types().at(option.type).cpp << " " << option.member << "{};\n";
+  }
+  out << "\n"
+      << "  // How many times each option was given\n"
+      << "  std::array<std::size_t, " << spec.options.size() << "> counts{};\n"
+      << "  // Arguments that no option or positional option consumed\n"
+      << "  std::vector<std::string> unmatched{};\n\n"
+      << "  std::size_t\n"
+      << "  count(Option option) const\n"
+      << "  {\n"
+      << "    return counts[static_cast<std::size_t>(option)];\n"
+      << "  }\n"
+      << "};\n\n";
+
+  out << "// Parses the arguments the same way as options().parse\n"
+      << "inline\n"
+      << spec.struct_name << "\n"
+      << "parse(int argc, const char* const* argv)\n"
+      << "{\n"
+      << "  static constexpr char names[] = " << literal(names) << ";\n"
+      << "  static constexpr cxxopts::codegen::NameEntry entries[] = {";
+  write_list(out, entries);
+  out << "  static constexpr std::uint32_t displacements[] = {";
+  write_list(out, hash.displacements());
+  out << "  static constexpr std::uint32_t slots[] = {";
+  write_list(out, hash.slots());
+  out << "  static constexpr cxxopts::codegen::OptionInfo options[] = {\n";
+  for (const auto& option : spec.options)
+  {
+    const auto& value = *option.value;
+    out << "    {"
+        << (value.has_default() ? literal(value.get_default_value()) : "nullptr") << ", "
+        << (value.has_implicit() ? literal(value.get_implicit_value()) : "nullptr") << ", "
+        << (value.is_container() ? "true" : "false") << "},\n";
+  }
+  out << "  };\n";
+  if (!positional.empty())
+  {
+    out << "  static constexpr std::size_t positional[] = {";
+    write_list(out, positional);
+  }
+  out << "  static constexpr cxxopts::codegen::Schema schema = {\n"
+      << "    names, entries,\n"
+      << "    displacements, " << hash.bucket_mask() << "u, slots, " << hash.slot_mask() << "u,\n"
+      << "    options, " << spec.options.size() << ",\n"
+      << "    " << (positional.empty() ? "nullptr" : "positional") << ", "
+      << positional.size() << ",\n"
+      << "    " << (spec.allow_unrecognised ? "true" : "false") << "\n"
+      << "  };\n\n";
+
+  out << "  " << spec.struct_name << " config;\n"
+      << "  cxxopts::codegen::parse(schema, config.counts.data(), config.unmatched,\n"
+      << "    [&config](std::size_t option, const std::string& text, bool"
+      << (has_lists ? " add" : "") << ") {\n"
+      << "      switch (static_cast<Option>(option))\n"
+      << "      {\n";
+  for (const auto& option : spec.options)
+  {
+    out << "        case Option::" << option.member << ":\n";
+    if (option.value->is_container())
+    {
+      out << "          if (add)\n"
+          << "          {\n"
+          << "            cxxopts::values::add_value(text, config." << option.member << ");\n"
+          << "          }\n"
+          << "          else\n"
+          << "          {\n"
+          << "            cxxopts::values::parse_value(text, config." << option.member << ",\n"
+          << "              " << list_format(option) << ");\n"
+          << "          }\n";
+    }
+    else
+    {
+      out << "          cxxopts::values::parse_value(text, config." << option.member << ");\n";
+    }
+    out << "          break;\n";
+  }
+  out << "      }\n"
+      << "    }, argc, argv);\n"
+      << "  return config;\n"
+      << "}\n\n";
+
+  const auto help_text = options.help();
+  std::istringstream help(help_text);
+  out << "// The help text, the same as options().help(), rendered when this\n"
+      << "// header was generated\n"
+      << "inline\n"
+      << "const char*\n"
+      << "help()\n"
+      << "{\n"
+      << "  return\n";
+  std::string line;
+  while (std::getline(help, line))
+  {
+    out << "    " << literal(line + (help.eof() ? "" : "\n")) << "\n";
+  }
+  out << "    ;\n"
+      << "}\n\n"
+      << "constexpr std::size_t help_length = " << help_text.size() << ";\n\n"
+      << "// Writes the help text with a single fwrite\n"
+      << "inline\n"
+      << "bool\n"
+      << "print_help(std::FILE* file = stdout)\n"
+      << "{\n"
+      << "  return std::fwrite(help(), 1, help_length, file) == help_length;\n"
+      << "}\n\n";
+
+  out << "// The same options as a cxxopts::Options\n"
+      << "inline\n"
+      << "cxxopts::Options\n"
+      << "options()\n"
+      << "{\n"
+      << "  cxxopts::Options result(" << literal(spec.program) << ", "
+      << literal(spec.description) << ");\n"
+      << "  result.set_width(" << spec.width << ");\n";
+  if (spec.has_custom_help)
+  {
+    out << "  result.custom_help(" << literal(spec.custom_help) << ");\n";
+  }
+  if (spec.has_positional_help)
+  {
+    out << "  result.positional_help(" << literal(spec.positional_help) << ");\n";
+  }
+  if (spec.show_positional_help)
+  {
+    out << "  result.show_positional_help();\n";
+  }
+  if (spec.allow_unrecognised)
+  {
+    out << "  result.allow_unrecognised_options();\n";
+  }
+  for (std::size_t i = 0; i != spec.options.size(); ++i)
+  {
+    const auto& option = spec.options[i];
+    if (i == 0 || option.group != spec.options[i - 1].group)
+    {
+      out << "  result.add_options(" << literal(option.group) << ")\n";
+    }
+    out << "    (" << literal(option.opts) << ", " << literal(option.desc) << ",\n"
+        << "      cxxopts::value<" << types().at(option.type).cpp << ">()";
+    if (option.has_default)
+    {
+      out << "->default_value(" << literal(option.default_value) << ")";
+    }
+    if (option.has_implicit)
+    {
+      out << "->implicit_value(" << literal(option.implicit_value) << ")";
+    }
+    if (option.has_delimiter)
+    {
+      out << "->delimiter(" << char_literal(option.delimiter) << ", "
+          << char_literal(option.quote) << ")";
+    }
+    if (!option.arg_help.empty())
+    {
+      out << ", " << literal(option.arg_help);
+    }
+    out << ")\n";
+    if (i + 1 == spec.options.size() || spec.options[i + 1].group != option.group)
+    {
+      out << "    ;\n";
+    }
+  }
+  if (!spec.positional.empty())
+  {
+    out << "  result.parse_positional({";
+    for (std::size_t i = 0; i != spec.positional.size(); ++i)
+    {
+      out << (i == 0 ? "" : ", ") << literal(spec.positional[i]);
+    }
+    out << "});\n";
+  }
+  out << "  return result;\n"
+      << "}\n\n";
+
+  if (!spec.name_space.empty())
+  {
+    out << "} // namespace " << spec.name_space << "\n\n";
+  }
+  out << "#endif\n";
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+  cxxopts::Options options("cxxopts-codegen",
+    " - writes a header with a typed parser for a file of option specs");
+  options.add_options()
+    ("spec", "The option spec file", cxxopts::value<std::string>())
+    ("output", "The header to write", cxxopts::value<std::string>())
+    ("width", "The width of the help text, instead of the spec's",
+      cxxopts::value<std::size_t>(), "N")
+    ("h,help", "Print help")
+    ;
+  options.parse_positional({"spec", "output"});
+  options.positional_help("SPEC OUTPUT");
+
+  std::string spec_file;
+  try
+  {
+    auto result = options.parse(argc, argv);
+    if (result.count("help") || !result.count("spec") || !result.count("output"))
+    {
+      std::cout << options.help() << std::endl;
+      return result.count("help") ? 0 : 1;
+    }
+
+    spec_file = result["spec"].as<std::string>();
+    std::ifstream in(spec_file);
+    if (!in)
+    {
+      throw std::runtime_error("cannot open the spec");
+    }
+    auto spec = read_spec(in);
+    if (result.count("width"))
+    {
+      spec.width = result["width"].as<std::size_t>();
+    }
+
+    // Written to a string first, so that a failure leaves no header behind
+    std::ostringstream header;
+    auto source = spec_file.substr(spec_file.find_last_of("/\\") + 1);
+    write_header(header, spec, source);
+
+    const auto& output = result["output"].as<std::string>();
+    std::ofstream out(output, std::ios::binary);
+    out << header.str();
+    if (!out)
+    {
+      std::cerr << output << ": cannot write the header" << std::endl;
+      return 1;
+    }
+  }
+  catch (const SpecError& e)
+  {
+    std::cerr << spec_file << ":" << e.what() << std::endl;
+    return 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << (spec_file.empty() ? "" : spec_file + ": ") << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,837 @@
+// Micro benchmarks for cxxopts. They are not part of the test suite, build the
+// options_benchmark target and run it directly, optionally naming the
+// benchmarks to run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "reference_wrap_text.hpp"
+
+namespace {
+
+// Results are added to a volatile so that the work is not optimised away.
+// Write `sink = sink + x`, since C++20 deprecates `+=` on a volatile.
+volatile std::size_t sink = 0;
+// Per thread, so that counting does not add contention to threaded benchmarks
+thread_local std::size_t allocations = 0;
+// The largest single allocation since it was last reset
+thread_local std::size_t largest_allocation = 0;
+
+} // namespace
+
+// Counting replacements for the global allocation functions. GCC flags the
+// malloc/free pair once both are inlined into a new/delete pair, which is
+// exactly what a replacement is meant to do.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void*
+operator new(std::size_t size)
+{
+  ++allocations;
+  largest_allocation = (std::max)(largest_allocation, size);
+  if (void* p = std::malloc(size != 0 ? size : 1))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// Counts the allocations made by one call to `f`
+template <typename F>
+std::size_t
+count_allocations(F&& f)
+{
+  const auto before = allocations;
+  f();
+  return allocations - before;
+}
+
+// Runs `f` until at least `min_time` has passed and returns the average time
+// per item in nanoseconds, where each call to `f` processes `items` items.
+template <typename F>
+double
+nanoseconds_per_item(std::size_t items, F&& f)
+{
+  using clock = std::chrono::steady_clock;
+  const auto min_time = std::chrono::milliseconds(200);
+
+  std::size_t iterations = 0;
+  const auto start = clock::now();
+  auto elapsed = clock::duration::zero();
+  do
+  {
+    // Keep the clock out of the measurement for very cheap calls
+    for (int i = 0; i != 64; ++i)
+    {
+      f();
+    }
+    iterations += 64;
+    elapsed = clock::now() - start;
+  } while (elapsed < min_time);
+
+  return static_cast<double>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+    static_cast<double>(iterations * items);
+}
+
+void
+report(const std::string& name, double baseline, double current)
+{
+  std::cout << "  " << name << ": " << baseline << " ns -> " << current
+            << " ns (" << baseline / current << "x)\n";
+}
+
+// The std::regex based matcher that ParseArgument used before it was
+// replaced by the hand written scanner, kept as the baseline.
+bool
+regex_match_argument(const char* arg)
+{
+  static const std::regex option_matcher(
+    "--([^-=,[:space:][:cntrl:]][^=,[:space:][:cntrl:]]+)(=(.*))?|"
+    "-([^-=,[:space:][:cntrl:]])((=(.*))|(.*))");
+  std::match_results<const char*> result;
+  return std::regex_match(arg, result, option_matcher);
+}
+
+bool
+scan_argument(const char* arg)
+{
+  cxxopts::values::parser_tool::ArguScan scan;
+  return cxxopts::values::parser_tool::scan_argument(arg, scan);
+}
+
+void
+argument_scanner()
+{
+  const std::string long_value = "--data=" + std::string(200, 'x');
+  const std::vector<const char*> arguments = {
+    "--long", "--name=value", "-a", "-abc", "-o=file", "positional",
+    long_value.c_str(),
+  };
+
+  std::cout << "ns per argv element, regex -> scanner\n";
+  for (const auto* argument : arguments)
+  {
+    auto regex = nanoseconds_per_item(1, [&] {
+      sink = sink + regex_match_argument(argument);
+    });
+    auto scanner = nanoseconds_per_item(1, [&] {
+      sink = sink + scan_argument(argument);
+    });
+    report(std::string(argument).substr(0, 20), regex, scanner);
+  }
+}
+
+// The integer parser from before the single pass one, kept as the baseline.
+// It split the text into strings first and checked for overflow by division
+// on every digit.
+template <typename T>
+void
+split_integer_parser(const std::string& text, T& value)
+{
+  if (text.empty())
+  {
+    throw cxxopts::exceptions::incorrect_argument_type(text);
+  }
+  std::string negative, base, digits;
+  const char* pdata = text.c_str();
+  if (*pdata == '-')
+  {
+    pdata += 1;
+    negative = "-";
+  }
+  if (std::strncmp(pdata, "0x", 2) == 0)
+  {
+    pdata += 2;
+    base = "0x";
+  }
+  if (*pdata == '\0')
+  {
+    throw cxxopts::exceptions::incorrect_argument_type(text);
+  }
+  digits = std::string(pdata);
+
+  using US = typename std::make_unsigned<T>::type;
+  const bool is_negative = !negative.empty();
+  const US radix = base.empty() ? 10 : 16;
+  US result = 0;
+  for (char ch : digits)
+  {
+    US digit = 0;
+    if (ch >= '0' && ch <= '9')
+    {
+      digit = static_cast<US>(ch - '0');
+    }
+    else if (radix == 16 && ch >= 'a' && ch <= 'f')
+    {
+      digit = static_cast<US>(ch - 'a' + 10);
+    }
+    else
+    {
+      throw cxxopts::exceptions::incorrect_argument_type(text);
+    }
+
+    const US limit = is_negative
+      ? static_cast<US>(static_cast<US>((std::numeric_limits<T>::max)()) + 1)
+      : static_cast<US>((std::numeric_limits<T>::max)());
+    if (result > limit / radix || result * radix > limit - digit)
+    {
+      throw cxxopts::exceptions::incorrect_argument_type(text);
+    }
+    result = static_cast<US>(result * radix + digit);
+  }
+  value = is_negative ? static_cast<T>(0 - result) : static_cast<T>(result);
+}
+
+template <typename T>
+void
+integer_type(const char* name)
+{
+  // Spread over the range of the type, including its extremes
+  std::vector<std::string> texts;
+  const auto max = static_cast<std::uint64_t>((std::numeric_limits<T>::max)());
+  for (std::uint64_t value = max; value != 0; value /= 3)
+  {
+    texts.push_back(std::to_string(value));
+  }
+  if (std::numeric_limits<T>::is_signed)
+  {
+    texts.push_back(std::to_string(static_cast<long long>((std::numeric_limits<T>::min)())));
+  }
+
+  T value = 0;
+  auto split = nanoseconds_per_item(texts.size(), [&] {
+    for (const auto& text : texts)
+    {
+      split_integer_parser(text, value);
+      sink = sink + static_cast<std::size_t>(value);
+    }
+  });
+  auto single = nanoseconds_per_item(texts.size(), [&] {
+    for (const auto& text : texts)
+    {
+      cxxopts::values::integer_parser(text, value);
+      sink = sink + static_cast<std::size_t>(value);
+    }
+  });
+  report(name, split, single);
+}
+
+void
+integer_parser()
+{
+  std::cout << "ns per integer, split -> single pass\n";
+  integer_type<std::int8_t>("int8");
+  integer_type<std::uint8_t>("uint8");
+  integer_type<std::int16_t>("int16");
+  integer_type<std::uint16_t>("uint16");
+  integer_type<std::int32_t>("int32");
+  integer_type<std::uint32_t>("uint32");
+  integer_type<std::int64_t>("int64");
+  integer_type<std::uint64_t>("uint64");
+}
+
+// How a vector of floating point values was parsed before, with a
+// stringstream for every element.
+void
+stringstream_vector(const std::string& text, std::vector<double>& values)
+{
+  std::stringstream in(text);
+  std::string token;
+  while (!in.eof() && std::getline(in, token, ','))
+  {
+    double value = 0;
+    std::stringstream element(token);
+    element >> value;
+    if (!element)
+    {
+      throw cxxopts::exceptions::incorrect_argument_type(token);
+    }
+    values.push_back(value);
+  }
+}
+
+void
+double_vector()
+{
+  const std::size_t count = 100000;
+  std::string text;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    text += (i == 0 ? "" : ",") + std::to_string(static_cast<double>(i) * 0.37);
+  }
+
+  std::vector<double> values;
+  values.reserve(count);
+#ifdef CXXOPTS_HAS_FROM_CHARS
+  std::cout << "ns per element of a 100k vector<double>, stringstream -> from_chars\n";
+#else
+  std::cout << "ns per element of a 100k vector<double>, stringstream -> classic locale stream\n";
+#endif
+  auto stream = nanoseconds_per_item(count, [&] {
+    values.clear();
+    stringstream_vector(text, values);
+    sink = sink + values.size();
+  });
+  auto current = nanoseconds_per_item(count, [&] {
+    values.clear();
+    cxxopts::values::parse_value(text, values);
+    sink = sink + values.size();
+  });
+  report("parse_value", stream, current);
+}
+
+void
+string_vector()
+{
+  const std::size_t count = 50000;
+  std::cout << "ns per element of a 50k vector<string>, getline -> in place split\n";
+
+  // Short elements fit in the small string buffer, long ones are allocated
+  for (const auto* suffix : {"", ".example.com:8080"})
+  {
+    std::string text;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      text += (i == 0 ? "" : ",") + ("h" + std::to_string(i) + suffix);
+    }
+
+    std::vector<std::string> values;
+    auto getline = nanoseconds_per_item(count, [&] {
+      values.clear();
+      std::stringstream in(text);
+      std::string token;
+      while (!in.eof() && std::getline(in, token, ','))
+      {
+        values.push_back(token);
+      }
+      sink = sink + values.size();
+    });
+    auto split = nanoseconds_per_item(count, [&] {
+      values.clear();
+      cxxopts::values::parse_value(text, values);
+      sink = sink + values.size();
+    });
+    report(*suffix == '\0' ? "short elements" : "long elements", getline, split);
+  }
+}
+
+void
+option_lookup()
+{
+  cxxopts::OptionMap map;
+  std::vector<std::string> names;
+  for (int i = 0; i != 5000; ++i)
+  {
+    names.push_back("option-name-" + std::to_string(i));
+    map.emplace(names.back(), nullptr);
+  }
+  cxxopts::OptionIndex index(map);
+
+  // Lookups during parsing start from a pointer into argv
+  std::cout << "ns per lookup with 5000 options, unordered_map -> index\n";
+  auto hashed = nanoseconds_per_item(names.size(), [&] {
+    for (const auto& name : names)
+    {
+      sink = sink + map.count(std::string(name.c_str(), name.size()));
+    }
+  });
+  auto indexed = nanoseconds_per_item(names.size(), [&] {
+    for (const auto& name : names)
+    {
+      sink = sink + (index.find(name.c_str(), name.size()) != nullptr);
+    }
+  });
+  report("long names", hashed, indexed);
+}
+
+void
+parse_into()
+{
+  cxxopts::Options options("benchmark", "parse_into benchmark");
+  options.add_options()
+    ("v,verbose", "verbose")
+    ("t,threads", "threads", cxxopts::value<int>()->default_value("4"))
+    ("n,name", "name", cxxopts::value<std::string>())
+    ("o,output", "output file", cxxopts::value<std::string>()->default_value("out.txt"))
+    ("i,ids", "ids", cxxopts::value<std::vector<int>>())
+    ("r,ratio", "ratio", cxxopts::value<double>())
+    ("files", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  for (int i = 0; i != 20; ++i)
+  {
+    options.add_options()("unused-" + std::to_string(i), "unused", cxxopts::value<int>());
+  }
+  options.parse_positional("files");
+
+  const char* argv[] = {
+    "benchmark", "-v", "--threads=8", "--name", "a-name-that-does-not-fit-in-sso",
+    "-i", "1,2,3,4", "--ratio", "0.25", "/path/to/the/first/input/file",
+    "/path/to/the/second/input/file",
+  };
+  const int argc = sizeof(argv) / sizeof(argv[0]);
+
+  cxxopts::ParseResult result;
+  options.parse_into(result, argc, argv);
+
+  std::cout << "allocations per parse, parse -> parse_into\n";
+  auto fresh = count_allocations([&] {
+    sink = sink + options.parse(argc, argv).count("verbose");
+  });
+  auto reused = count_allocations([&] {
+    options.parse_into(result, argc, argv);
+    sink = sink + result.count("verbose");
+  });
+  std::cout << "  " << fresh << " -> " << reused << "\n";
+
+  std::cout << "ns per parse, parse -> parse_into\n";
+  auto fresh_time = nanoseconds_per_item(1, [&] {
+    sink = sink + options.parse(argc, argv).count("verbose");
+  });
+  auto reused_time = nanoseconds_per_item(1, [&] {
+    options.parse_into(result, argc, argv);
+    sink = sink + result.count("verbose");
+  });
+  report("27 options, 10 arguments", fresh_time, reused_time);
+}
+
+void
+lazy_conversion()
+{
+  // A wrapper that forwards many options but reads only a few of them
+  cxxopts::Options options("benchmark", "lazy conversion benchmark");
+  std::vector<std::string> arguments = {"benchmark"};
+  for (int i = 0; i != 200; ++i)
+  {
+    const auto name = "option-" + std::to_string(i);
+    options.add_options()(name, "forwarded", cxxopts::value<std::vector<double>>());
+    arguments.push_back("--" + name + "=1.5,2.5,3.5");
+  }
+
+  std::vector<const char*> argv;
+  for (const auto& argument : arguments)
+  {
+    argv.push_back(argument.c_str());
+  }
+  const int argc = static_cast<int>(argv.size());
+
+  auto measure = [&] {
+    cxxopts::ParseResult result;
+    return nanoseconds_per_item(1, [&] {
+      options.parse_into(result, argc, argv.data());
+      sink = sink + result["option-0"].as<std::vector<double>>().size();
+    });
+  };
+
+  std::cout << "ns per parse of 200 options reading one, eager -> lazy\n";
+  auto eager = measure();
+  options.set_lazy_conversion();
+  auto lazy = measure();
+  report("vector<double> values", eager, lazy);
+}
+
+void
+concurrent_parse()
+{
+  cxxopts::Options options("benchmark", "concurrent parse benchmark");
+  options.add_options()
+    ("v,verbose", "verbose")
+    ("t,threads", "threads", cxxopts::value<int>()->default_value("4"))
+    ("n,name", "name", cxxopts::value<std::string>())
+    ("i,ids", "ids", cxxopts::value<std::vector<int>>())
+    ("files", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("files");
+  const auto compiled = options.compile();
+
+  const char* argv[] = {
+    "benchmark", "-v", "--threads=8", "--name", "a-name-that-does-not-fit-in-sso",
+    "-i", "1,2,3,4", "/path/to/the/first/input/file",
+  };
+  const int argc = sizeof(argv) / sizeof(argv[0]);
+  const std::size_t parses = 2000;
+
+  // Every thread parses the same compiled options into its own result
+  std::cout << "parses per second by thread count, with "
+            << std::thread::hardware_concurrency() << " hardware threads\n";
+  for (std::size_t thread_count = 1; thread_count <= 64; thread_count *= 2)
+  {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+
+    std::vector<std::size_t> found(thread_count);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t != thread_count; ++t)
+    {
+      threads.emplace_back([&, t] {
+        cxxopts::ParseResult result;
+        for (std::size_t i = 0; i != parses; ++i)
+        {
+          compiled.parse_into(result, argc, argv);
+          found[t] += result.count("verbose");
+        }
+      });
+    }
+    for (std::size_t t = 0; t != thread_count; ++t)
+    {
+      threads[t].join();
+      sink = sink + found[t];
+    }
+
+    const auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << "  " << thread_count << " threads: "
+              << static_cast<double>(parses * thread_count) / seconds << "\n";
+  }
+}
+
+void
+handle_access()
+{
+  cxxopts::Options options("benchmark", "handle access benchmark");
+  auto threads = options.add_option<int>("", "t,threads", "threads",
+    cxxopts::value<int>()->default_value("4"));
+  auto name = options.add_option<std::string>("", "n,name", "name");
+  for (int i = 0; i != 20; ++i)
+  {
+    options.add_options()("unused-" + std::to_string(i), "unused", cxxopts::value<int>());
+  }
+
+  const char* argv[] = {"benchmark", "--threads=8", "--name", "a-name"};
+  auto result = options.parse(4, argv);
+
+  std::cout << "ns per read of two values, operator[] -> handle or key\n";
+  auto by_name = nanoseconds_per_item(1, [&] {
+    sink = sink + static_cast<std::size_t>(result["threads"].as<int>());
+    sink = sink + result["name"].as<std::string>().size();
+  });
+  auto by_handle = nanoseconds_per_item(1, [&] {
+    sink = sink + static_cast<std::size_t>(result.get(threads));
+    sink = sink + result.get(name).size();
+  });
+  report("handle", by_name, by_handle);
+
+  using namespace cxxopts::literals;
+  auto by_key = nanoseconds_per_item(1, [&] {
+    sink = sink + static_cast<std::size_t>(result.get<int>("threads"_opt));
+    sink = sink + result.get<std::string>("name"_opt).size();
+  });
+  report("compile time key", by_name, by_key);
+}
+
+struct BenchmarkConfig
+{
+  bool verbose = false;
+  int threads = 0;
+  std::string name{};
+  std::vector<int> ids{};
+  double ratio = 0;
+};
+
+void
+bind_struct()
+{
+  const char* argv[] = {
+    "benchmark", "-v", "--threads=8", "--name", "a-name-that-does-not-fit-in-sso",
+    "-i", "1,2,3,4", "--ratio", "0.25",
+  };
+  const int argc = sizeof(argv) / sizeof(argv[0]);
+
+  cxxopts::Options options("benchmark", "bind benchmark");
+  options.add_options()
+    ("v,verbose", "verbose")
+    ("t,threads", "threads", cxxopts::value<int>()->default_value("4"))
+    ("n,name", "name", cxxopts::value<std::string>())
+    ("i,ids", "ids", cxxopts::value<std::vector<int>>())
+    ("r,ratio", "ratio", cxxopts::value<double>())
+    ;
+
+  cxxopts::Options bound("benchmark", "bind benchmark");
+  auto binder = cxxopts::bind<BenchmarkConfig>(bound)
+    .add("v,verbose", &BenchmarkConfig::verbose, "verbose")
+    .add("t,threads", &BenchmarkConfig::threads, "threads",
+      cxxopts::value<int>()->default_value("4"))
+    .add("n,name", &BenchmarkConfig::name, "name")
+    .add("i,ids", &BenchmarkConfig::ids, "ids")
+    .add("r,ratio", &BenchmarkConfig::ratio, "ratio");
+
+  std::cout << "ns per parse into a struct, parse and copy -> bind\n";
+  auto copied = nanoseconds_per_item(1, [&] {
+    auto result = options.parse(argc, argv);
+    BenchmarkConfig config;
+    config.verbose = result["verbose"].as<bool>();
+    config.threads = result["threads"].as<int>();
+    config.name = result["name"].as<std::string>();
+    config.ids = result["ids"].as<std::vector<int>>();
+    config.ratio = result["ratio"].as<double>();
+    sink = sink + config.ids.size();
+  });
+  auto bound_parse = nanoseconds_per_item(1, [&] {
+    BenchmarkConfig config;
+    binder.parse(config, argc, argv);
+    sink = sink + config.ids.size();
+  });
+  report("parse", copied, bound_parse);
+}
+
+#define SPEC(i) {"option-" #i, "an option", &cxxopts::value<int>}
+#define SPEC10(i) SPEC(i##0), SPEC(i##1), SPEC(i##2), SPEC(i##3), SPEC(i##4), \
+  SPEC(i##5), SPEC(i##6), SPEC(i##7), SPEC(i##8), SPEC(i##9)
+#define SPEC100(i) SPEC10(i##0), SPEC10(i##1), SPEC10(i##2), SPEC10(i##3), \
+  SPEC10(i##4), SPEC10(i##5), SPEC10(i##6), SPEC10(i##7), SPEC10(i##8), SPEC10(i##9)
+#define SPEC1000(i) SPEC100(i##0), SPEC100(i##1), SPEC100(i##2), SPEC100(i##3), \
+  SPEC100(i##4), SPEC100(i##5), SPEC100(i##6), SPEC100(i##7), SPEC100(i##8), SPEC100(i##9)
+
+constexpr cxxopts::OptionSpec static_specs[] = {SPEC1000(1), SPEC1000(2), SPEC1000(3)};
+
+#undef SPEC1000
+#undef SPEC100
+#undef SPEC10
+#undef SPEC
+
+void
+static_specs_startup()
+{
+  const auto count = sizeof(static_specs) / sizeof(static_specs[0]);
+  std::vector<std::string> names;
+  for (const auto& spec : static_specs)
+  {
+    names.emplace_back(spec.opts());
+  }
+
+  std::cout << "ns per option adding 3000 options, add_options() -> OptionSpec\n";
+  auto added = nanoseconds_per_item(count, [&] {
+    cxxopts::Options options("benchmark", "startup benchmark");
+    auto adder = options.add_options();
+    for (const auto& name : names)
+    {
+      adder(name, "an option", cxxopts::value<int>());
+    }
+    options.freeze();
+    sink = sink + options.groups().size();
+  });
+  auto specs = nanoseconds_per_item(count, [&] {
+    cxxopts::Options options("benchmark", "startup benchmark");
+    options.add_options("", static_specs);
+    options.freeze();
+    sink = sink + options.groups().size();
+  });
+  report("add and freeze", added, specs);
+}
+
+#ifndef CXXOPTS_USE_UNICODE
+void
+wrap_text()
+{
+  std::string prose;
+  std::string identifiers;
+  for (int i = 0; i != 2000; ++i)
+  {
+    prose += "a description made of short words that is wrapped over many lines ";
+    identifiers += "some_rather_long_identifier::with_a_namespace_and_a_path/to/a/file ";
+  }
+
+  std::cout << "ns per KB of description, scalar -> wrap_text\n";
+  for (const auto* text : {&prose, &identifiers})
+  {
+    const auto kb = text->size() / 1024;
+    auto scalar = nanoseconds_per_item(kb, [&] {
+      sink = sink + reference_wrap_text(*text, 46, 32).size();
+    });
+    auto scanned = nanoseconds_per_item(kb, [&] {
+      sink = sink + cxxopts::wrap_text(*text, 46, 32).size();
+    });
+    report(text == &prose ? "prose" : "identifiers", scalar, scanned);
+  }
+}
+#endif
+
+void
+help_cache()
+{
+  cxxopts::Options options("benchmark", " - help benchmark");
+  auto adder = options.add_options();
+  for (int i = 0; i != 50; ++i)
+  {
+    const auto name = "option-" + std::to_string(i);
+    adder(name, "An option with a description long enough to be wrapped over "
+      "more than one line of the help text", cxxopts::value<int>()->default_value("1"));
+  }
+
+  std::cout << "ns per help() with 50 options, rendered -> cached\n";
+  auto rendered = nanoseconds_per_item(1, [&] {
+    // changing the width discards the cached text
+    options.set_width(76);
+    sink = sink + options.help().size();
+  });
+  auto cached = nanoseconds_per_item(1, [&] {
+    sink = sink + options.help().size();
+  });
+  report("help", rendered, cached);
+}
+
+// Discards what is written to it
+class NullBuffer : public std::streambuf
+{
+  protected:
+  int_type
+  overflow(int_type c) override
+  {
+    return c;
+  }
+
+  std::streamsize
+  xsputn(const char*, std::streamsize count) override
+  {
+    return count;
+  }
+};
+
+void
+help_stream()
+{
+  cxxopts::Options options("benchmark", " - help benchmark");
+  auto adder = options.add_options();
+  for (int i = 0; i != 5000; ++i)
+  {
+    const auto name = "option-" + std::to_string(i);
+    adder(name, "An option with a description long enough to be wrapped over "
+      "more than one line of the help text", cxxopts::value<int>()->default_value("1"));
+  }
+
+  NullBuffer buffer;
+  std::ostream null(&buffer);
+
+  std::cout << "ns per option of help with 5000 options, help() -> help_to\n";
+  auto built = nanoseconds_per_item(5000, [&] {
+    options.set_width(76);
+    null << options.help();
+  });
+  auto streamed = nanoseconds_per_item(5000, [&] {
+    options.help_to(null);
+  });
+  report("help", built, streamed);
+
+  std::size_t largest = 0;
+  std::cout << "largest allocation rendering the help, help() -> help_to\n";
+  largest_allocation = 0;
+  options.set_width(76);
+  null << options.help();
+  largest = largest_allocation;
+  largest_allocation = 0;
+  options.help_to(null);
+  std::cout << "  " << largest << " bytes -> " << largest_allocation << " bytes\n";
+}
+
+void
+parallel_list()
+{
+  const std::size_t count = 2000000;
+  std::string text;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    text += (i == 0 ? "" : ",") + std::to_string(static_cast<double>(i) / 8);
+  }
+
+  // Each run converts one 2M element list, so time single calls directly
+  std::cout << "ms per 2M element vector<double> by thread count, with "
+            << std::thread::hardware_concurrency() << " hardware threads\n";
+  for (unsigned thread_count = 1; thread_count <= 8; thread_count *= 2)
+  {
+    cxxopts::values::ListFormat format;
+    format.threads = thread_count;
+
+    using clock = std::chrono::steady_clock;
+    auto best = clock::duration::max();
+    std::vector<double> values;
+    for (int i = 0; i != 5; ++i)
+    {
+      values.clear();
+      const auto start = clock::now();
+      cxxopts::values::parse_value(text, values, format);
+      best = (std::min)(best, clock::now() - start);
+      sink = sink + values.size();
+    }
+    std::cout << "  " << thread_count << " threads: "
+              << std::chrono::duration<double, std::milli>(best).count() << "\n";
+  }
+}
+
+struct Benchmark
+{
+  const char* name;
+  void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+  {"argument_scanner", argument_scanner},
+  {"option_lookup", option_lookup},
+  {"integer_parser", integer_parser},
+  {"double_vector", double_vector},
+  {"string_vector", string_vector},
+  {"parse_into", parse_into},
+  {"lazy_conversion", lazy_conversion},
+  {"handle_access", handle_access},
+  {"bind_struct", bind_struct},
+  {"static_specs_startup", static_specs_startup},
+#ifndef CXXOPTS_USE_UNICODE
+  {"wrap_text", wrap_text},
+#endif
+  {"help_cache", help_cache},
+  {"help_stream", help_stream},
+  {"concurrent_parse", concurrent_parse},
+  {"parallel_list", parallel_list},
+};
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  for (const auto& benchmark : benchmarks)
+  {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; ++i)
+    {
+      selected = selected || std::strcmp(argv[i], benchmark.name) == 0;
+    }
+
+    if (selected)
+    {
+      std::cout << benchmark.name << "\n";
+      benchmark.run();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "codegen.hpp"
+
+namespace {
+
+std::vector<const char*>
+make_argv(std::initializer_list<const char*> args)
+{
+  return std::vector<const char*>(args);
+}
+
+template <typename T>
+void
+check_option
+(
+  const codegen_test::Config& config,
+  const cxxopts::ParseResult& result,
+  codegen_test::Option option,
+  const char* name,
+  const T& value
+)
+{
+  INFO(name);
+  CHECK(config.count(option) == result.count(name));
+  if (result.count(name) != 0 || result[name].has_default())
+  {
+    CHECK(value == result[name].as<T>());
+  }
+}
+
+// Parses with the generated parser and with cxxopts::Options, and checks
+// that they give the same values
+void
+compare(std::initializer_list<const char*> args)
+{
+  const auto argv = make_argv(args);
+  const auto argc = static_cast<int>(argv.size());
+  const auto config = codegen_test::parse(argc, argv.data());
+  auto options = codegen_test::options();
+  const auto result = options.parse(argc, argv.data());
+
+  using codegen_test::Option;
+  check_option(config, result, Option::help, "help", config.help);
+  check_option(config, result, Option::verbose, "verbose", config.verbose);
+  check_option(config, result, Option::threads, "threads", config.threads);
+  check_option(config, result, Option::output, "output", config.output);
+  check_option(config, result, Option::level, "level", config.level);
+  check_option(config, result, Option::rate, "rate", config.rate);
+  check_option(config, result, Option::extra, "x", config.extra);
+  check_option(config, result, Option::delays, "delays", config.delays);
+  check_option(config, result, Option::names, "names", config.names);
+  check_option(config, result, Option::input, "input", config.input);
+  check_option(config, result, Option::files, "files", config.files);
+  CHECK(config.unmatched == result.unmatched());
+}
+
+template <typename Exception>
+void
+compare_error(std::initializer_list<const char*> args)
+{
+  const auto argv = make_argv(args);
+  const auto argc = static_cast<int>(argv.size());
+  auto options = codegen_test::options();
+  CHECK_THROWS_AS(codegen_test::parse(argc, argv.data()), Exception);
+  CHECK_THROWS_AS(options.parse(argc, argv.data()), Exception);
+}
+
+} // namespace
+
+TEST_CASE("Generated parser", "[codegen]")
+{
+  compare({"codegen"});
+  compare({"codegen", "-v", "--threads", "8", "-o"});
+  compare({"codegen", "-vt16", "--output=out", "-l", "--rate", "2.5"});
+  compare({"codegen", "-x", "-42", "--level=7", "-h"});
+  compare({"codegen", "-d", "1;2.5;3", "--delays=4", "--names", "a,'b,c',d"});
+  compare({"codegen", "in", "one", "--verbose", "two", "--", "three", "-v"});
+  compare({"codegen", "--input", "in", "one", "two"});
+}
+
+TEST_CASE("Generated parser errors", "[codegen]")
+{
+  compare_error<cxxopts::exceptions::no_such_option>({"codegen", "--unknown"});
+  compare_error<cxxopts::exceptions::no_such_option>({"codegen", "-vq"});
+  compare_error<cxxopts::exceptions::missing_argument>({"codegen", "--threads"});
+  compare_error<cxxopts::exceptions::incorrect_argument_type>({"codegen", "-t", "many"});
+  compare_error<cxxopts::exceptions::incorrect_argument_type>({"codegen", "--level=300"});
+  compare_error<cxxopts::exceptions::invalid_option_syntax>({"codegen", "--=x"});
+}
+
+TEST_CASE("Generated help", "[codegen]")
+{
+  const std::string help = codegen_test::help();
+  CHECK(help == codegen_test::options().help());
+  CHECK(help.size() == codegen_test::help_length);
+
+  // the build generates the header with a width of 60 instead of the spec's
+  std::istringstream lines(help);
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    CHECK(line.size() <= 60);
+  }
+
+  auto* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  CHECK(codegen_test::print_help(file));
+  std::rewind(file);
+  std::string written(help.size() + 1, '\0');
+  written.resize(std::fread(&written[0], 1, written.size(), file));
+  std::fclose(file);
+  CHECK(written == help);
+}
@@ -0,0 +1,22 @@
+# Options for codegen.cpp, which compares the generated parser with
+# cxxopts::Options
+program codegen " - test the generated parser"
+namespace codegen_test
+struct Config
+width 70
+positional_help "FILE..."
+positional input files
+
+option h,help bool "Print help"
+option v,verbose bool "Verbose output"
+option t,threads int "Number of threads" default=4 arg=N
+option o,output string "Output file" default=a.out implicit=b.out arg=FILE
+option l,level uint8 "Level" implicit=3
+option r,rate double "Rate, in \"Hz\""
+option x int64 "A short only option" member=extra
+
+group Lists
+option d,delays vector<double> "Delays" delimiter=;
+option names vector<string> "Names" delimiter=, quote="'"
+option input string "The input file"
+option files vector<string> "The remaining files"
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+namespace {
+
+// Each block starts with its size, so that the bytes still in use are known
+// when it is freed.
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+std::size_t live_bytes = 0;
+std::size_t live_blocks = 0;
+std::size_t total_blocks = 0;
+
+} // namespace
+
+// Counting replacements for the global allocation functions. GCC flags the
+// malloc/free pair once both are inlined into a new/delete pair, which is
+// exactly what a replacement is meant to do.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void*
+operator new(std::size_t size)
+{
+  if (auto p = static_cast<char*>(std::malloc(header_size + size)))
+  {
+    *reinterpret_cast<std::size_t*>(p) = size;
+    live_bytes += size;
+    ++live_blocks;
+    ++total_blocks;
+    return p + header_size;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+  if (p != nullptr)
+  {
+    auto block = static_cast<char*>(p) - header_size;
+    live_bytes -= *reinterpret_cast<std::size_t*>(block);
+    --live_blocks;
+    std::free(block);
+  }
+}
+
+#ifdef __cpp_sized_deallocation
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  operator delete(p);
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+TEST_CASE("Bytes per registered option", "[footprint]")
+{
+  constexpr std::size_t count = 1000;
+
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    names.push_back("option-" + std::to_string(i));
+  }
+  const std::string desc = "An option with a description that is long enough "
+    "to be stored on the heap";
+
+  // What any way of keeping the options has to hold: each value and its own
+  // copy of the description. Measured rather than assumed, since the sizes of
+  // std::string, std::shared_ptr and the values differ between standard
+  // libraries.
+  auto before = live_bytes;
+  auto blocks_before = live_blocks;
+  std::vector<std::pair<std::shared_ptr<cxxopts::Value>, std::string>> plain;
+  plain.reserve(count);
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    plain.emplace_back(cxxopts::value<int>()->default_value("42"), desc);
+  }
+  const auto baseline = static_cast<double>(live_bytes - before) / count;
+  const auto baseline_blocks = static_cast<double>(live_blocks - blocks_before) / count;
+  plain.clear();
+  plain.shrink_to_fit();
+
+  before = live_bytes;
+  blocks_before = live_blocks;
+  cxxopts::Options options("footprint");
+  auto adder = options.add_options();
+  for (const auto& name : names)
+  {
+    adder(name, desc, cxxopts::value<int>()->default_value("42"), "N");
+  }
+
+  // The name table, the option itself with its value, and the help entry.
+  // With libstdc++ this is 516 bytes in 4 blocks against a baseline of 290
+  // bytes in 3, where keeping the names and descriptions in strings of their
+  // own took 802 bytes in 8.
+  const auto per_option = static_cast<double>(live_bytes - before) / count;
+  const auto blocks_per_option =
+    static_cast<double>(live_blocks - blocks_before) / count;
+  INFO("bytes per option: " << per_option << ", baseline " << baseline);
+  INFO("blocks per option: " << blocks_per_option << ", baseline " << baseline_blocks);
+  CHECK(per_option < 2 * baseline);
+  CHECK(blocks_per_option < baseline_blocks + 2);
+
+  // Help still shows everything that was stored for it
+  options.set_width(200);
+  CHECK(options.help().find("  --option-999 N  An option with a description "
+    "that is long enough to be stored on the heap (default: 42)") !=
+    std::string::npos);
+}
+
+TEST_CASE("Adding an option allocates only what it keeps", "[footprint]")
+{
+  static_assert(std::is_nothrow_move_constructible<cxxopts::NameList>::value &&
+    std::is_nothrow_move_assignable<cxxopts::NameList>::value,
+    "the long names of an option move without allocating");
+
+  constexpr std::size_t count = 1000;
+
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<cxxopts::Value>> values;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    // only the first option has a short name as well
+    names.push_back((i == 0 ? "o,option-" : "option-") + std::to_string(i));
+    values.push_back(cxxopts::value<int>());
+  }
+
+  cxxopts::Options options("footprint");
+  auto adder = options.add_options();
+  const auto live_before = live_blocks;
+  const auto total_before = total_blocks;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    adder(names[i], "An option", values[i]);
+  }
+
+  // Blocks that were allocated and freed again while adding. Growing the
+  // name table and the help still frees the blocks it replaces, but only a
+  // few times over all the options, not for each one.
+  const auto transient = (total_blocks - total_before) - (live_blocks - live_before);
+  INFO("transient blocks: " << transient);
+  CHECK(transient < count / 10);
+}
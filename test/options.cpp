@@ -1,9 +1,13 @@
 #include "catch.hpp"
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include <initializer_list>
+#include <locale>
 
 #include "cxxopts.hpp"
+#include "reference_wrap_text.hpp"
 
 class Argv {
   public:
@@ -929,6 +933,49 @@ TEST_CASE("Overflow on boundary", "[integer]")
   CHECK_THROWS_AS((integer_parser("-28446744073709551616", si64)), cxxopts::exceptions::incorrect_argument_type);
 }
 
+TEST_CASE("Integer prefixes and separators", "[integer]")
+{
+  using namespace cxxopts::values;
+
+  int i = 0;
+  int8_t si = 0;
+  int64_t si64 = 0;
+  uint8_t ui = 0;
+  uint64_t ui64 = 0;
+
+  integer_parser("0b101", i);
+  CHECK(i == 5);
+  integer_parser("-0b1000_0000", si);
+  CHECK(si == -128);
+  integer_parser("0o755", i);
+  CHECK(i == 0755);
+  integer_parser("0o377", ui);
+  CHECK(ui == 255);
+  integer_parser("1_000_000", i);
+  CHECK(i == 1000000);
+  integer_parser("0xdead_BEEF", ui64);
+  CHECK(ui64 == 0xdeadbeef);
+  integer_parser("18446744073709551615", ui64);
+  CHECK(ui64 == UINT64_MAX);
+  integer_parser("-9223372036854775808", si64);
+  CHECK(si64 == INT64_MIN);
+  integer_parser("-0", si);
+  CHECK(si == 0);
+  si = 1;
+  integer_parser("0x", si);
+  CHECK(si == 0);
+
+  for (const char* bad : {"", "-", "0b", "0o", "_1", "1_", "1__0", "0x_1",
+      "0b2", "0o8", "12a", "+1", "0X1", " 1", "1 "})
+  {
+    CAPTURE(bad);
+    CHECK_THROWS_AS(integer_parser(bad, i), cxxopts::exceptions::incorrect_argument_type);
+  }
+  CHECK_THROWS_AS((integer_parser("0b1_0000_0000", ui)), cxxopts::exceptions::incorrect_argument_type);
+  CHECK_THROWS_AS((integer_parser("-0", ui)), cxxopts::exceptions::incorrect_argument_type);
+  CHECK_THROWS_AS((integer_parser("0o400", ui)), cxxopts::exceptions::incorrect_argument_type);
+}
+
 TEST_CASE("Integer overflow", "[options]")
 {
   using namespace cxxopts::values;
@@ -977,6 +1024,47 @@ TEST_CASE("Floats", "[options]")
   CHECK(positional[3] == -1.5e6);
 }
 
+namespace {
+
+class comma_decimal : public std::numpunct<char>
+{
+  protected:
+  char
+  do_decimal_point() const override
+  {
+    return ',';
+  }
+};
+
+} // namespace
+
+TEST_CASE("Floats ignore the global locale", "[options]")
+{
+  using namespace cxxopts::values;
+
+  const auto previous = std::locale::global(
+    std::locale(std::locale::classic(), new comma_decimal));
+
+  double d = 0;
+  float f = 0;
+  long double ld = 0;
+  parse_value("0.5", d);
+  parse_value("+2.25", f);
+  parse_value("-1.5e3", ld);
+
+  std::locale::global(previous);
+
+  CHECK(d == 0.5);
+  CHECK(f == 2.25f);
+  CHECK(ld == -1500.0L);
+
+  for (const char* bad : {"", "0,5", "1.5x", " 1", "1 ", "+", "+-1", "abc", "1e999"})
+  {
+    CAPTURE(bad);
+    CHECK_THROWS_AS(parse_value(bad, d), cxxopts::exceptions::incorrect_argument_type);
+  }
+}
+
 TEST_CASE("Invalid integers", "[integer]") {
     cxxopts::Options options("invalid_integers", "rejects invalid integers");
     options.add_options()
@@ -1035,6 +1123,33 @@ TEST_CASE("Booleans", "[boolean]") {
   REQUIRE(result.count("others") == 1);
 }
 
+TEST_CASE("Boolean spellings", "[boolean]") {
+  using namespace cxxopts::values;
+
+  for (const char* text : {"true", "True", "TRUE", "t", "T", "1", "yes", "Yes", "on", "ON"})
+  {
+    CAPTURE(text);
+    bool value = false;
+    parse_value(text, value);
+    CHECK(value);
+  }
+
+  for (const char* text : {"false", "False", "FALSE", "f", "F", "0", "no", "NO", "off", "Off"})
+  {
+    CAPTURE(text);
+    bool value = true;
+    parse_value(text, value);
+    CHECK_FALSE(value);
+  }
+
+  for (const char* text : {"", "tr", "tru", "truee", "yess", "of", "2", "01", "o n", "\x11"})
+  {
+    CAPTURE(text);
+    bool value = false;
+    CHECK_THROWS_AS(parse_value(text, value), cxxopts::exceptions::incorrect_argument_type);
+  }
+}
+
 TEST_CASE("std::vector", "[vector]") {
   std::vector<double> vector;
   cxxopts::Options options("vector", " - tests vector");
@@ -1055,6 +1170,168 @@ TEST_CASE("std::vector", "[vector]") {
   CHECK(vector[3] == 4.5);
 }
 
+TEST_CASE("Vector delimiters and quoting", "[vector]") {
+  cxxopts::Options options("vector", " - tests vector delimiters");
+  options.add_options()
+    ("hosts", "hosts", cxxopts::value<std::vector<std::string>>()->delimiter(';'))
+    ("names", "names", cxxopts::value<std::vector<std::string>>()->delimiter(',', '"'))
+    ("shards", "shards", cxxopts::value<std::vector<int>>()
+      ->delimiter(':')->default_value("1:2:3"))
+    ("plain", "plain", cxxopts::value<std::vector<std::string>>())
+    ;
+
+  SECTION("Per option delimiters") {
+    Argv av({"vector", "--hosts=a;b,c;d", "--names", "x,\"y,z\",,\"\"", "--plain", "p,\"q,r\",s,"});
+    auto result = options.parse(av.argc(), av.argv());
+
+    CHECK(result["hosts"].as<std::vector<std::string>>() ==
+      std::vector<std::string>{"a", "b,c", "d"});
+    CHECK(result["names"].as<std::vector<std::string>>() ==
+      std::vector<std::string>{"x", "y,z", "", ""});
+    CHECK(result["shards"].as<std::vector<int>>() == std::vector<int>{1, 2, 3});
+    // no quoting unless it is asked for, and a trailing delimiter is ignored
+    CHECK(result["plain"].as<std::vector<std::string>>() ==
+      std::vector<std::string>{"p", "\"q", "r\"", "s"});
+  }
+
+  SECTION("Bad quoting") {
+    Argv unterminated({"vector", "--names=a,\"b,c"});
+    CHECK_THROWS_AS(options.parse(unterminated.argc(), unterminated.argv()),
+      cxxopts::exceptions::incorrect_argument_type);
+
+    Argv trailing({"vector", "--names=\"a\"b,c"});
+    CHECK_THROWS_AS(options.parse(trailing.argc(), trailing.argv()),
+      cxxopts::exceptions::incorrect_argument_type);
+  }
+
+  SECTION("Long lists") {
+    std::string shards;
+    for (int i = 0; i != 50000; ++i)
+    {
+      shards += (i == 0 ? "" : ":") + std::to_string(i);
+    }
+    Argv av({"vector", "--shards", shards.c_str()});
+    auto result = options.parse(av.argc(), av.argv());
+
+    const auto& values = result["shards"].as<std::vector<int>>();
+    REQUIRE(values.size() == 50000);
+    CHECK(values.front() == 0);
+    CHECK(values.back() == 49999);
+  }
+}
+
+namespace {
+
+// A value written against the original Value interface, which relies on the
+// defaults for everything added to it since
+class LastWord : public cxxopts::Value
+{
+  public:
+  std::shared_ptr<cxxopts::Value> clone() const override
+  {
+    return std::make_shared<LastWord>(*this);
+  }
+
+  void add(const std::string& text) const override { parse(text); }
+  void parse(const std::string& text) const override { *m_word = text; }
+  void parse() const override {}
+  bool has_default() const override { return false; }
+  bool is_container() const override { return false; }
+  bool has_implicit() const override { return false; }
+  bool has_disabled_args() const override { return false; }
+  std::string get_default_value() const override { return ""; }
+  std::string get_implicit_value() const override { return ""; }
+  bool is_boolean() const override { return false; }
+
+  std::shared_ptr<cxxopts::Value>
+  default_value(const std::string&) override { return shared_from_this(); }
+
+  std::shared_ptr<cxxopts::Value>
+  implicit_value(const std::string&, cxxopts::ImplicitArgPolicy) override
+  {
+    return shared_from_this();
+  }
+
+  std::shared_ptr<cxxopts::Value>
+  no_implicit_value() override { return shared_from_this(); }
+
+  std::string
+  word() const { return *m_word; }
+
+  private:
+  std::shared_ptr<std::string> m_word = std::make_shared<std::string>();
+};
+
+} // namespace
+
+TEST_CASE("Custom values", "[options]") {
+  auto word = std::make_shared<LastWord>();
+  CHECK(word->delimiter(';')->parallel(2) == word);
+  CHECK_FALSE(word->has_external_storage());
+
+  cxxopts::Options options("custom", " - test custom values");
+  options.add_options()("w,word", "a word", word);
+
+  Argv av({"custom", "--word", "fish"});
+  cxxopts::ParseResult result;
+  options.parse_into(result, av.argc(), av.argv());
+  options.parse_into(result, av.argc(), av.argv());
+  CHECK(result.count("word") == 1);
+  CHECK(word->word() == "fish");
+}
+
+// Without CXXOPTS_USE_THREADS, parallel() is still accepted and the same
+// lists are converted serially, with the same results and errors.
+TEST_CASE("Parallel list conversion", "[vector][threads]") {
+  cxxopts::Options options("vector", " - tests parallel conversion");
+  options.add_options()
+    ("ids", "ids", cxxopts::value<std::vector<int>>()->parallel(4))
+    ("names", "names", cxxopts::value<std::vector<std::string>>()
+      ->delimiter(';', '"')->parallel(3))
+    ("flags", "flags", cxxopts::value<std::vector<bool>>()->parallel(4))
+    ("small", "small", cxxopts::value<std::vector<int>>()->parallel(4))
+    ;
+
+  const int count = 100000;
+  std::string ids, names, flags;
+  for (int i = 0; i != count; ++i)
+  {
+    ids += (i == 0 ? "" : ",") + std::to_string(i);
+    names += (i == 0 ? "\"" : ";\"") + std::to_string(i) + ";x\"";
+    flags += i == 0 ? "true" : (i % 2 ? ",false" : ",true");
+  }
+
+  Argv av({"vector", "--ids", ids.c_str(), "--names", names.c_str(),
+    "--flags", flags.c_str(), "--small=1,2,3"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  const auto& id_values = result["ids"].as<std::vector<int>>();
+  REQUIRE(id_values.size() == count);
+  bool in_order = true;
+  for (int i = 0; i != count; ++i)
+  {
+    in_order = in_order && id_values[static_cast<std::size_t>(i)] == i;
+  }
+  CHECK(in_order);
+
+  const auto& name_values = result["names"].as<std::vector<std::string>>();
+  REQUIRE(name_values.size() == count);
+  CHECK(name_values.front() == "0;x");
+  CHECK(name_values.back() == std::to_string(count - 1) + ";x");
+
+  CHECK(result["flags"].as<std::vector<bool>>().size() == count);
+  CHECK(result["small"].as<std::vector<int>>() == std::vector<int>{1, 2, 3});
+
+  SECTION("The first bad element is reported") {
+    auto bad = ids;
+    bad.replace(bad.find(",70000,"), 7, ",bad70000,");
+    bad.replace(bad.find(",20000,"), 7, ",bad20000,");
+    Argv av_bad({"vector", "--ids", bad.c_str()});
+    CHECK_THROWS_WITH(options.parse(av_bad.argc(), av_bad.argv()),
+      Catch::Contains("bad20000"));
+  }
+}
+
 TEST_CASE("empty std::vector", "[vector]") {
   std::vector<double> double_vector;
   std::vector<std::string> string_vector;
@@ -1133,6 +1410,88 @@ TEST_CASE("std::filesystem::path", "[path]") {
 }
 #endif
 
+#ifdef CXXOPTS_HAS_MEMORY_RESOURCE
+namespace {
+
+class counting_resource : public std::pmr::memory_resource
+{
+  public:
+  std::size_t allocations = 0;
+  std::size_t outstanding = 0;
+
+  private:
+  void*
+  do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    ++allocations;
+    ++outstanding;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void
+  do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+  {
+    --outstanding;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool
+  do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+} // namespace
+
+TEST_CASE("Parse with a memory resource", "[pmr]") {
+  int external = 0;
+  cxxopts::Options options("pmr", " - tests memory resources");
+  options.add_options()
+    ("a,apple", "an apple", cxxopts::value<int>())
+    ("b,banana", "a banana", cxxopts::value<std::string>()->default_value("yellow"))
+    ("c,cherry", "cherries", cxxopts::value<std::vector<int>>())
+    ("d,date", "a date", cxxopts::value<int>(external))
+    ("e,elder", "an elder")
+    ;
+
+  Argv av({"pmr", "-a", "1", "-c", "2,3", "-d", "4", "-e"});
+
+  // How many allocations each value takes is up to the standard library, so
+  // only check where they came from
+  counting_resource resource;
+  counting_resource fallback;
+  auto previous = std::pmr::set_default_resource(&fallback);
+  {
+    auto result = options.parse(av.argc(), av.argv(), &resource);
+    CHECK(result["apple"].as<int>() == 1);
+    CHECK(result["banana"].as<std::string>() == "yellow");
+    CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{2, 3});
+    CHECK(result["elder"].as<bool>());
+    CHECK(external == 4);
+
+    // at least one allocation for each value not written to a variable
+    const auto first = resource.allocations;
+    CHECK(first >= 4);
+
+    auto copy = result;
+    options.parse_into(result, av.argc(), av.argv());
+    CHECK(resource.allocations > first);
+    CHECK(copy["cherry"].as<std::vector<int>>() == std::vector<int>{2, 3});
+  }
+  std::pmr::set_default_resource(previous);
+  CHECK(resource.outstanding == 0);
+  CHECK(fallback.allocations == 0);
+
+  SECTION("Monotonic buffer") {
+    std::pmr::monotonic_buffer_resource arena;
+    auto result = options.parse(av.argc(), av.argv(), &arena);
+    CHECK(result["apple"].as<int>() == 1);
+    CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{2, 3});
+  }
+}
+#endif
+
 TEST_CASE("Unrecognised options", "[options]") {
   cxxopts::Options options("unknown_options", " - test unknown options");
 
@@ -1205,7 +1564,637 @@ TEST_CASE("Invalid option syntax", "[options]") {
   SECTION("Default behaviour") {
     CHECK_THROWS_AS(options.parse(argc, argv), cxxopts::exceptions::invalid_option_syntax);
   }
+
+  SECTION("Line breaks in values") {
+    options.add_options()
+      ("d,data", "some data", cxxopts::value<std::string>())
+      ("x", "a flag");
+
+    for (const auto* arg : {"--data=a\nb", "--data=a\rb", "-d=a\nb", "-da\nb",
+      "-x\n"})
+    {
+      INFO(arg);
+      Argv line_break({"invalid_syntax", arg});
+      CHECK_THROWS_AS(options.parse(line_break.argc(), line_break.argv()),
+        cxxopts::exceptions::invalid_option_syntax);
+    }
+  }
+}
+
+TEST_CASE("Very long arguments", "[options]") {
+  cxxopts::Options options("long_arguments", " - test very long arguments");
+  options.add_options()
+    ("d,data", "some data", cxxopts::value<std::string>());
+
+  const std::string data(1 << 20, 'x');
+  const std::string long_arg = "--data=" + data;
+  const std::string short_arg = "-d=" + data;
+
+  SECTION("Long option") {
+    Argv av({"long_arguments", long_arg.c_str()});
+    auto result = options.parse(av.argc(), av.argv());
+    CHECK(result["data"].as<std::string>() == data);
+  }
+
+  SECTION("Short option") {
+    Argv av({"long_arguments", short_arg.c_str()});
+    auto result = options.parse(av.argc(), av.argv());
+    CHECK(result["data"].as<std::string>() == data);
+  }
+}
+
+TEST_CASE("Option index", "[index]") {
+  SECTION("Every name is found") {
+    cxxopts::OptionMap map;
+    for (int i = 0; i != 5000; ++i) {
+      auto name = "option-" + std::to_string(i);
+      map.emplace(name, std::make_shared<cxxopts::OptionDetails>(
+        "", cxxopts::OptionNames{name}, "", cxxopts::value<int>(), i));
+    }
+
+    cxxopts::OptionIndex index(map);
+    REQUIRE(index.size() == map.size());
+    for (const auto& entry : map) {
+      auto details = index.find(entry.first);
+      REQUIRE(details != nullptr);
+      CHECK(details->get() == entry.second.get());
+    }
+
+    // Each option is listed once, at its own index
+    REQUIRE(index.options().size() == map.size());
+    for (std::size_t i = 0; i != index.options().size(); ++i) {
+      CHECK(index.options()[i]->index() == i);
+    }
+
+    CHECK(index.find("option-5000") == nullptr);
+    CHECK(index.find("option-") == nullptr);
+    CHECK(index.find("") == nullptr);
+  }
+
+  SECTION("Empty index") {
+    cxxopts::OptionIndex index;
+    CHECK(index.find("anything") == nullptr);
+  }
+
+  SECTION("Equal hashes have no perfect table") {
+    cxxopts::detail::PerfectHash hash;
+    CHECK_FALSE(hash.build({1, 2, 1}));
+    CHECK(hash.find(1) == 0);
+    CHECK(hash.build({1, 2, 3}));
+    CHECK(hash.find(2) != 0);
+  }
+
+  SECTION("Parsing with many options") {
+    cxxopts::Options options("index", " - test option index");
+    for (int i = 0; i != 3000; ++i) {
+      options.add_options()("option-" + std::to_string(i), "an option",
+        cxxopts::value<int>());
+    }
+    options.add_options()("a,apple", "an apple");
+    options.freeze();
+
+    Argv av({"index", "--option-42=42", "--option-2999", "7", "-a"});
+    auto result = options.parse(av.argc(), av.argv());
+    CHECK(result["option-42"].as<int>() == 42);
+    CHECK(result["option-2999"].as<int>() == 7);
+    CHECK(result.count("option-0") == 0);
+    CHECK(result.count("apple") == 1);
+
+    // Adding an option after freezing makes it visible to the next parse
+    options.add_options()("late", "a late option");
+    Argv late({"index", "--late"});
+    CHECK(options.parse(late.argc(), late.argv()).count("late") == 1);
+  }
+}
+
+TEST_CASE("Results outlive their options", "[options]") {
+  cxxopts::ParseResult result;
+  CHECK(result.count("apple") == 0);
+
+  {
+    cxxopts::Options options("outlive", " - results outlive options");
+    options.add_options()("a,apple", "an apple", cxxopts::value<int>());
+
+    Argv av({"outlive", "--apple", "3"});
+    result = options.parse(av.argc(), av.argv());
+    options.add_options()("banana", "a banana");
+  }
+
+  CHECK(result.count("a") == 1);
+  CHECK(result["apple"].as<int>() == 3);
+  CHECK(result.count("banana") == 0);
+  CHECK_THROWS_AS(result["banana"], cxxopts::exceptions::requested_option_not_present);
+}
+
+TEST_CASE("Parse into an existing result", "[options]") {
+  cxxopts::Options options("parse_into", " - test reusing results");
+  options.add_options()
+    ("a,apple", "an apple", cxxopts::value<int>())
+    ("b,banana", "a banana", cxxopts::value<std::string>()->default_value("yellow"))
+    ("c,cherry", "cherries", cxxopts::value<std::vector<int>>())
+    ("positional", "positional", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("positional");
+  options.allow_unrecognised_options();
+
+  Argv first({"parse_into", "--apple", "1", "-c", "1,2", "--unknown", "x", "y"});
+  Argv second({"parse_into", "-c", "3", "--banana=green"});
+
+  cxxopts::ParseResult result;
+  options.parse_into(result, first.argc(), first.argv());
+  CHECK(result["apple"].as<int>() == 1);
+  CHECK(result["banana"].as<std::string>() == "yellow");
+  CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{1, 2});
+  CHECK(result.arguments().size() == 4);
+  CHECK(result.defaults().size() == 1);
+  CHECK(result.unmatched() == std::vector<std::string>{"--unknown"});
+
+  auto copy = result;
+
+  options.parse_into(result, second.argc(), second.argv());
+  CHECK(result.count("apple") == 0);
+  CHECK_THROWS_AS(result["apple"].as<int>(), cxxopts::exceptions::option_has_no_value);
+  CHECK(result["banana"].as<std::string>() == "green");
+  CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{3});
+  CHECK(result.count("positional") == 0);
+  CHECK(result.arguments().size() == 2);
+  CHECK(result.defaults().empty());
+  CHECK(result.unmatched().empty());
+
+  // a copy taken before reusing the result keeps its own values
+  CHECK(copy["apple"].as<int>() == 1);
+  CHECK(copy["cherry"].as<std::vector<int>>() == std::vector<int>{1, 2});
+  CHECK(copy["positional"].as<std::vector<std::string>>() ==
+    std::vector<std::string>{"x", "y"});
+
+  SECTION("Into a result from other options") {
+    cxxopts::Options other("other", " - other options");
+    other.add_options()("d,date", "a date", cxxopts::value<int>());
+
+    Argv av({"other", "-d", "4"});
+    other.parse_into(result, av.argc(), av.argv());
+    CHECK(result["date"].as<int>() == 4);
+    CHECK(result.count("apple") == 0);
+  }
+
+  SECTION("A failed parse leaves the result empty") {
+    Argv av({"parse_into", "-c", "4", "x", "--apple", "pear"});
+    CHECK_THROWS_AS(options.parse_into(result, av.argc(), av.argv()),
+      cxxopts::exceptions::incorrect_argument_type);
+    CHECK(result.count("apple") == 0);
+    CHECK(result.count("cherry") == 0);
+    CHECK(result.count("positional") == 0);
+    CHECK(result.arguments().empty());
+    CHECK(result.defaults().empty());
+    CHECK(result.unmatched().empty());
+
+    // and can still be parsed into
+    options.parse_into(result, first.argc(), first.argv());
+    CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{1, 2});
+    CHECK(result.arguments().size() == 4);
+  }
+}
+
+TEST_CASE("Compiled options", "[options]") {
+  cxxopts::Options options("compiled", " - test compiled options");
+  options.add_options()
+    ("a,apple", "an apple", cxxopts::value<int>())
+    ("positional", "positional", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("positional");
+
+  auto compiled = options.compile();
+
+  // later changes to the options are not seen by the snapshot
+  options.add_options()("b,banana", "a banana");
+  options.allow_unrecognised_options();
+
+  Argv av({"compiled", "-a", "1", "x", "y"});
+  auto result = compiled.parse(av.argc(), av.argv());
+  CHECK(result["apple"].as<int>() == 1);
+  CHECK(result["positional"].as<std::vector<std::string>>() ==
+    std::vector<std::string>{"x", "y"});
+
+  Argv banana({"compiled", "-b"});
+  CHECK_THROWS_AS(compiled.parse(banana.argc(), banana.argv()),
+    cxxopts::exceptions::no_such_option);
+  CHECK(options.parse(banana.argc(), banana.argv()).count("banana") == 1);
+}
+
+#ifndef CXXOPTS_NO_THREADS
+TEST_CASE("Parse compiled options from many threads", "[options][threads]") {
+  cxxopts::Options options("threads", " - test concurrent parsing");
+  options.add_options()
+    ("i,id", "an id", cxxopts::value<int>())
+    ("n,name", "a name", cxxopts::value<std::string>()->default_value("none"))
+    ("l,list", "a list", cxxopts::value<std::vector<int>>())
+    ("f,flag", "a flag")
+    ("rest", "the rest", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("rest");
+  const auto compiled = options.compile();
+
+  const int thread_count = 8;
+  const int iterations = 500;
+  std::atomic<int> failures{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t != thread_count; ++t)
+  {
+    threads.emplace_back([&compiled, &failures, t] {
+      const auto id = std::to_string(t);
+      const auto name = "a-name-that-is-too-long-for-sso-" + id;
+      const auto list = id + "," + id;
+      Argv av({"threads", "--id", id.c_str(), "-n", name.c_str(), "-fl",
+        list.c_str(), "positional", id.c_str()});
+
+      cxxopts::ParseResult reused;
+      for (int i = 0; i != iterations; ++i)
+      {
+        auto fresh = compiled.parse(av.argc(), av.argv());
+        compiled.parse_into(reused, av.argc(), av.argv());
+        for (const auto* result : {&fresh, &reused})
+        {
+          if ((*result)["id"].as<int>() != t ||
+              (*result)["name"].as<std::string>() != name ||
+              (*result)["list"].as<std::vector<int>>() != std::vector<int>{t, t} ||
+              !(*result)["flag"].as<bool>() ||
+              (*result)["rest"].as<std::vector<std::string>>() !=
+                std::vector<std::string>{"positional", id} ||
+              result->arguments().size() != 6)
+          {
+            ++failures;
+          }
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  CHECK(failures == 0);
+}
+#endif
+
+TEST_CASE("Lazy conversion", "[options]") {
+  int bound = 0;
+  cxxopts::Options options("lazy", " - test lazy conversion");
+  options.add_options()
+    ("a,apple", "an apple", cxxopts::value<int>())
+    ("b,banana", "a banana", cxxopts::value<std::string>()->default_value("yellow"))
+    ("c,cherry", "cherries", cxxopts::value<std::vector<int>>())
+    ("d,date", "a date", cxxopts::value<int>(bound))
+    ("e,elder", "an elder")
+    ("positional", "positional", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("positional");
+  options.set_lazy_conversion();
+
+  Argv av({"lazy", "-a", "1", "-a", "2", "-c", "1,2", "-c", "3", "-d", "4",
+    "-e", "x", "y"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  // bound variables are still written while parsing
+  CHECK(bound == 4);
+  CHECK(result.count("apple") == 2);
+  CHECK(result.count("banana") == 0);
+  CHECK(result.arguments().size() == 8);
+
+  CHECK(result["apple"].as<int>() == 2);
+  CHECK(result["banana"].as<std::string>() == "yellow");
+  CHECK(result["banana"].has_default());
+  CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{1, 2, 3});
+  CHECK(result["elder"].as<bool>());
+  CHECK(result["positional"].as<std::vector<std::string>>() ==
+    std::vector<std::string>{"x", "y"});
+
+  SECTION("Errors are reported on access") {
+    Argv bad({"lazy", "-a", "one", "-c", "1,two"});
+    options.parse_into(result, bad.argc(), bad.argv());
+    CHECK(result.count("apple") == 1);
+    CHECK_THROWS_AS(result["apple"], cxxopts::exceptions::incorrect_argument_type);
+    CHECK_THROWS_AS(result["apple"], cxxopts::exceptions::incorrect_argument_type);
+    CHECK_THROWS_AS(result.validate(), cxxopts::exceptions::incorrect_argument_type);
+    CHECK(result["banana"].as<std::string>() == "yellow");
+  }
+
+  SECTION("Validate converts everything") {
+    Argv bad({"lazy", "-c", "1,two"});
+    options.parse_into(result, bad.argc(), bad.argv());
+    CHECK_THROWS_AS(result.validate(), cxxopts::exceptions::incorrect_argument_type);
+
+    Argv good({"lazy", "-c", "5"});
+    options.parse_into(result, good.argc(), good.argv());
+    result.validate();
+    CHECK(result["cherry"].as<std::vector<int>>() == std::vector<int>{5});
+    CHECK(result.count("apple") == 0);
+  }
+
+#ifndef CXXOPTS_NO_THREADS
+  SECTION("Reading from many threads") {
+    Argv many({"lazy", "-a", "7", "-c", "1,2,3", "-e"});
+    options.parse_into(result, many.argc(), many.argv());
+
+    const cxxopts::ParseResult& shared = result;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i != 4; ++i)
+    {
+      threads.emplace_back([&]() {
+        for (int j = 0; j != 100; ++j)
+        {
+          if (shared["apple"].as<int>() != 7 ||
+              shared["cherry"].as<std::vector<int>>().size() != 3 ||
+              !shared["elder"].as<bool>())
+          {
+            ++failures;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    CHECK(failures == 0);
+  }
+#endif
+}
+
+TEST_CASE("Option handles", "[options]") {
+  cxxopts::Options options("handles", " - test option handles");
+  auto threads = options.add_option<int>("", "t,threads", "threads",
+    cxxopts::value<int>()->default_value("4"));
+  auto verbose = options.add_option<bool>("", "v,verbose", "verbose");
+
+  cxxopts::OptionHandle<std::string> name;
+  cxxopts::OptionHandle<std::vector<int>> ids;
+  CHECK(!name.valid());
+  options.add_options()
+    ("other", "other", cxxopts::value<int>())
+    (name, "n,name", "name", cxxopts::value<std::string>())
+    (ids, "ids", "ids", cxxopts::value<std::vector<int>>())
+    ;
+  CHECK(name.valid());
+  CHECK(name.index() == 3);
+
+  Argv av({"handles", "-v", "--name", "x", "--ids=1,2", "--ids=3"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK(result.get(threads) == 4);
+  CHECK(result.count(threads) == 0);
+  CHECK(result.get(verbose));
+  CHECK(result.count(verbose) == 1);
+  CHECK(result.get(name) == "x");
+  CHECK(result.get(ids) == std::vector<int>{1, 2, 3});
+  CHECK(result.get(name) == result["name"].as<std::string>());
+
+  SECTION("Options without a value throw") {
+    Argv empty({"handles"});
+    auto empty_result = options.parse(empty.argc(), empty.argv());
+    CHECK(empty_result.count(name) == 0);
+    CHECK_THROWS_AS(empty_result.get(name), cxxopts::exceptions::option_has_no_value);
+    CHECK_THROWS_AS(cxxopts::ParseResult().get(name),
+      cxxopts::exceptions::option_has_no_value);
+  }
+
+  SECTION("Handles from other options") {
+    cxxopts::Options other("other", " - other options");
+    auto other_threads = other.add_option<int>("", "threads", "threads",
+      cxxopts::value<int>()->default_value("8"));
+    other.add_options()("v,verbose", "verbose");
+    Argv other_av({"other", "-v"});
+    auto other_result = other.parse(other_av.argc(), other_av.argv());
+    CHECK(other_result.get(other_threads) == 8);
+    CHECK(other_result.count(verbose) == 0);
+    CHECK_THROWS_AS(other_result.get(threads), cxxopts::exceptions::foreign_option_handle);
+    CHECK_THROWS_AS(result.get(other_threads), cxxopts::exceptions::foreign_option_handle);
+
+    // a copy of the options is the same set of options, and options added
+    // through either of them take the next index
+    auto copy = options;
+    CHECK(copy.parse(av.argc(), av.argv()).get(name) == "x");
+    auto level = copy.add_option<int>("", "level", "level", cxxopts::value<int>());
+    auto depth = options.add_option<int>("", "depth", "depth", cxxopts::value<int>());
+    CHECK(level.index() == 5);
+    CHECK(depth.index() == 6);
+    Argv more({"handles", "--level=1", "--depth=2"});
+    auto more_result = options.parse(more.argc(), more.argv());
+    CHECK(more_result.get(level) == 1);
+    CHECK(more_result.get(depth) == 2);
+  }
+
+  SECTION("A name that exists takes no index") {
+    CHECK_THROWS_AS(options.add_options()("q,quiet,verbose", "quiet"),
+      cxxopts::exceptions::option_already_exists);
+    auto quiet = options.add_option<bool>("", "q,quiet", "quiet");
+    CHECK(quiet.index() == 5);
+    Argv quiet_av({"handles", "-q", "-v"});
+    auto quiet_result = options.parse(quiet_av.argc(), quiet_av.argv());
+    CHECK(quiet_result.get(quiet));
+    CHECK(quiet_result.get(verbose));
+  }
+
+  SECTION("Lazy conversion") {
+    options.set_lazy_conversion();
+    Argv lazy({"handles", "--ids=4,5"});
+    auto lazy_result = options.parse(lazy.argc(), lazy.argv());
+    CHECK(lazy_result.get(ids) == std::vector<int>{4, 5});
+  }
+
+#ifndef CXXOPTS_NO_RTTI
+  SECTION("The value must hold the handle type") {
+    CHECK_THROWS_AS(options.add_option<long>("", "count", "count", cxxopts::value<int>()),
+      cxxopts::exceptions::option_handle_type_mismatch);
+  }
+#endif
+}
+
+namespace {
+constexpr const char* key_names[] = {"threads", "t", "name", "absent"};
+constexpr cxxopts::OptionSchema key_schema(key_names);
+}
+
+TEST_CASE("Compile time option keys", "[options]") {
+  using namespace cxxopts::literals;
+
+  constexpr auto threads = "threads"_opt;
+  static_assert(threads.length() == 7, "length of a literal key");
+  static_assert(key_schema.size() == 4, "schema size");
+  static_assert(key_schema.contains("name") && !key_schema.contains("nam"),
+    "schema lookup");
+  static_assert(key_schema.key("t").hash() == "t"_opt.hash(),
+    "schema keys hash like literals");
+  CHECK(threads.hash() == cxxopts::detail::hash_name("threads", 7));
+
+  cxxopts::Options options("keys", " - test compile time keys");
+  options.add_options()
+    ("t,threads", "threads", cxxopts::value<int>()->default_value("4"))
+    ("name", "name", cxxopts::value<std::string>())
+    ;
+
+  Argv av({"keys", "--name", "x"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  constexpr auto name = key_schema.key("name");
+  CHECK(result.get<int>(threads) == 4);
+  CHECK(result.get<int>("t"_opt) == 4);
+  CHECK(result.get<std::string>(name) == "x");
+  CHECK(result.count(name) == 1);
+  CHECK(result.count(threads) == 0);
+  CHECK(result.count(key_schema.key("absent")) == 0);
+
+  CHECK_THROWS_AS(result.get<int>(key_schema.key("absent")),
+    cxxopts::exceptions::requested_option_not_present);
+  CHECK_THROWS_AS(result.get<long>(threads), std::bad_cast);
+  // Outside of a constant expression, a name missing from the schema throws
+  CHECK_THROWS_AS(key_schema.key("missing"), cxxopts::exceptions::no_such_option);
+
+  SECTION("The schema is checked against the options") {
+    options.add_schema(key_schema);
+    CHECK_THROWS_WITH(options.parse(av.argc(), av.argv()),
+      Catch::Contains("absent"));
+    CHECK_THROWS_AS(options.compile(), cxxopts::exceptions::no_such_option);
+
+    options.add_options()("absent", "absent");
+    CHECK(options.parse(av.argc(), av.argv()).count(key_schema.key("absent")) == 0);
+  }
+}
+
+namespace {
+struct BoundConfig
+{
+  int threads = 0;
+  bool verbose = false;
+  std::string name = "unset";
+  std::vector<int> ids{};
+  std::vector<std::string> files{};
+};
+}
+
+TEST_CASE("Bind options to struct members", "[options]") {
+  cxxopts::Options options("bind", " - test binding to members");
+  auto binder = cxxopts::bind<BoundConfig>(options)
+    .add("t,threads", &BoundConfig::threads, "threads",
+      cxxopts::value<int>()->default_value("4"))
+    .add("v,verbose", &BoundConfig::verbose, "verbose")
+    .add("name", &BoundConfig::name, "name")
+    .add("ids", &BoundConfig::ids, "ids", cxxopts::value<std::vector<int>>()->delimiter(';'))
+    .add("files", &BoundConfig::files, "files");
+  options.add_options()("h,help", "help");
+  options.parse_positional("files");
+
+  BoundConfig config;
+  Argv av({"bind", "-v", "--ids=1;2", "a,b", "--ids", "3", "-h", "c"});
+  binder.parse(config, av.argc(), av.argv());
+
+  CHECK(config.threads == 4);
+  CHECK(config.verbose);
+  CHECK(config.name == "unset");
+  CHECK(config.ids == std::vector<int>{1, 2, 3});
+  CHECK(config.files == std::vector<std::string>{"a,b", "c"});
+
+  SECTION("Errors") {
+    Argv bad({"bind", "--threads=x"});
+    CHECK_THROWS_AS(binder.parse(config, bad.argc(), bad.argv()),
+      cxxopts::exceptions::incorrect_argument_type);
+    Argv unknown({"bind", "--unknown"});
+    CHECK_THROWS_AS(binder.parse(config, unknown.argc(), unknown.argv()),
+      cxxopts::exceptions::no_such_option);
+    CHECK_THROWS_AS(cxxopts::bind<BoundConfig>(options).add("count", &BoundConfig::threads,
+      "count", cxxopts::value<long>()), cxxopts::exceptions::option_handle_type_mismatch);
+  }
+
+  SECTION("Unmatched arguments") {
+    options.allow_unrecognised_options();
+    std::vector<std::string> unmatched;
+    BoundConfig other;
+    Argv av2({"bind", "--threads", "2", "--unknown", "--name=x"});
+    binder.parse(other, av2.argc(), av2.argv(), unmatched);
+    CHECK(other.threads == 2);
+    CHECK(other.name == "x");
+    CHECK(unmatched == std::vector<std::string>{"--unknown"});
+  }
+}
+
+namespace {
+constexpr cxxopts::OptionSpec static_specs[] = {
+  {"t,threads", "Thread count", &cxxopts::value<int>, "4"},
+  {"v, verbose", "Verbose output"},
+  {"level,l,lvl", "Level", &cxxopts::value<std::string>, nullptr, "high", "LEVEL"},
+  {"ids", "Ids", &cxxopts::value<std::vector<int>>},
+};
+}
+
+TEST_CASE("Static option specs", "[options]") {
+  static_assert(static_specs[0].name_count() == 2, "names of a spec");
+  static_assert(static_specs[1].name(1).offset == 3 &&
+    static_specs[1].name(1).length == 7, "spaces after a comma are skipped");
+  static_assert(static_specs[2].name_count() == 3 &&
+    static_specs[2].name(1).length == 1, "short name in the middle");
+
+  cxxopts::Options options("specs", " - test static specs");
+  options.add_options("", static_specs);
+
+  cxxopts::Options dynamic("specs", " - test static specs");
+  dynamic.add_options()
+    ("t,threads", "Thread count", cxxopts::value<int>()->default_value("4"))
+    ("v, verbose", "Verbose output")
+    ("level,l,lvl", "Level", cxxopts::value<std::string>()->implicit_value("high"), "LEVEL")
+    ("ids", "Ids", cxxopts::value<std::vector<int>>())
+    ;
+  CHECK(options.help() == dynamic.help());
+
+  Argv av({"specs", "-v", "--lvl", "--ids=1,2", "-l"});
+  auto result = options.parse(av.argc(), av.argv());
+  CHECK(result["threads"].as<int>() == 4);
+  CHECK(result["verbose"].as<bool>());
+  CHECK(result["level"].as<std::string>() == "high");
+  CHECK(result.count("l") == 2);
+  CHECK(result["ids"].as<std::vector<int>>() == std::vector<int>{1, 2});
+
+  // A spec that is not constexpr is checked when it is constructed
+  CHECK_THROWS_AS(cxxopts::OptionSpec(std::string("a,b").c_str(), ""),
+    cxxopts::exceptions::invalid_option_format);
+  CHECK_THROWS_AS(cxxopts::OptionSpec(std::string("-a").c_str(), ""),
+    cxxopts::exceptions::invalid_option_format);
+  CHECK_THROWS_AS(cxxopts::OptionSpec(std::string("ab,").c_str(), ""),
+    cxxopts::exceptions::invalid_option_format);
+  CHECK_THROWS_AS(cxxopts::OptionSpec(std::string("a1,a2,a3,a4,a5").c_str(), ""),
+    cxxopts::exceptions::invalid_option_format);
+  CHECK_THROWS_AS(options.add_options("", static_specs),
+    cxxopts::exceptions::option_already_exists);
+}
+
+#ifdef CXXOPTS_HAS_CONSTEVAL
+TEST_CASE("Option names checked at compile time", "[options]") {
+  using namespace cxxopts::literals;
+  static_assert(cxxopts::unique_names(static_specs));
+  constexpr cxxopts::OptionSpec repeated[] = {{"a,apple", ""}, {"b,apple", ""}};
+  static_assert(!cxxopts::unique_names(repeated));
+
+  cxxopts::Options options("names", " - test consteval names");
+  options.add_options()
+    ("a,apple,ringo"_names, "an apple")
+    ("b, banana"_names, "a banana", cxxopts::value<int>(), "N")
+    ;
+
+  cxxopts::Options dynamic("names", " - test consteval names");
+  dynamic.add_options()
+    ("a,apple,ringo", "an apple")
+    ("b, banana", "a banana", cxxopts::value<int>(), "N")
+    ;
+  CHECK(options.help() == dynamic.help());
+
+  Argv av({"names", "--ringo", "-b", "3"});
+  auto result = options.parse(av.argc(), av.argv());
+  CHECK(result.count("apple") == 1);
+  CHECK(result["banana"].as<int>() == 3);
 }
+#endif
 
 TEST_CASE("Options empty", "[options]") {
   cxxopts::Options options("Options list empty", " - test empty option list");
@@ -1538,6 +2527,116 @@ TEST_CASE("No Options help", "[options]")
   CHECK(options.help().find("test <posArg1>...<posArgN>") != std::string::npos);
 }
 
+TEST_CASE("Help is rendered again after the options change", "[help]")
+{
+  cxxopts::Options options("cached", " - test the help cache");
+  options.add_options()
+    ("a,apple", "an apple")
+    ("input", "the input", cxxopts::value<std::string>())
+    ;
+
+  const auto first = options.help();
+  CHECK(options.help() == first);
+  CHECK(options.help({""}, false) != first);
+  CHECK(first.find("--input") != std::string::npos);
+
+  options.add_options()("b,banana", "a banana");
+  const auto added = options.help();
+  CHECK(added.find("--banana") != std::string::npos);
+
+  options.parse_positional("input");
+  CHECK(options.help().find("--input") == std::string::npos);
+  options.show_positional_help();
+  CHECK(options.help().find("--input") != std::string::npos);
+
+  options.custom_help("[FLAGS]");
+  CHECK(options.help().find("[FLAGS]") != std::string::npos);
+  options.positional_help("INPUT");
+  CHECK(options.help().find("INPUT") != std::string::npos);
+
+  options.add_options()("d", std::string(100, 'x'));
+  options.set_width(200);
+  const auto wide = options.help();
+  CHECK(wide.find(std::string(100, 'x')) != std::string::npos);
+  options.set_width(60);
+  CHECK(options.help().find(std::string(100, 'x')) == std::string::npos);
+
+  auto copy = options;
+  copy.add_options()("c,cherry", "a cherry");
+  CHECK(copy.help().find("--cherry") != std::string::npos);
+  CHECK(options.help().find("--cherry") == std::string::npos);
+}
+
+TEST_CASE("Stream help", "[help]")
+{
+  cxxopts::Options options("stream", " - test streamed help");
+  options.positional_help("FILES");
+  options.add_options()
+    ("a,apple", "an apple with a description long enough to need wrapping over "
+      "more than one line of the help text")
+    ("a-very-long-option-name-that-does-not-fit", "a long name")
+    ("files", "the files", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.add_options("Group")
+    ("b,banana", "a banana", cxxopts::value<int>()->default_value("3"), "N")
+    ;
+  options.add_options("Hidden")
+    ("rest", "the rest", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"files", "rest"});
+
+  const std::vector<std::vector<std::string>> group_sets = {
+    {}, {"Group"}, {"", "Group"}, {"Hidden", "Group"}, {"Group", "missing"}};
+  for (const auto& groups : group_sets)
+  {
+    for (bool usage : {true, false})
+    {
+      std::ostringstream out;
+      options.help_to(out, groups, usage);
+      CHECK(out.str() == options.help(groups, usage));
+    }
+  }
+}
+
+#ifndef CXXOPTS_NO_THREADS
+TEST_CASE("Help from many threads", "[help][threads]")
+{
+  cxxopts::Options options("threads", " - test concurrent help");
+  options.add_options()
+    ("a,apple", "an apple")
+    ("g", "a grouped option")
+    ;
+  options.add_options("Group")
+    ("b,banana", "a banana", cxxopts::value<int>())
+    ;
+  const auto all = options.help();
+  const auto group = options.help({"Group"});
+  options.set_width(80);
+
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t != 8; ++t)
+  {
+    threads.emplace_back([&] {
+      for (int i = 0; i != 200; ++i)
+      {
+        if (options.help() != all || options.help({"Group"}) != group)
+        {
+          ++failures;
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  CHECK(failures == 0);
+}
+#endif
+
 TEST_CASE("Ordering of multiple long options", "[help]")
 {
   cxxopts::Options options("test", "Ordering of multiple long options");
@@ -1569,6 +2668,53 @@ TEST_CASE("Ordering of multiple long options", "[help]")
   CHECK(help.find("--beta") != std::string::npos);
 }
 
+TEST_CASE("Option names outlive their Options", "[options]")
+{
+  auto parse = [] {
+    cxxopts::Options options("test", "Names outlive options");
+    options.add_options()
+      ("f,file,input,source,path", "More long names than are kept inline",
+        cxxopts::value<std::string>())
+      ("n,name", "Never given", cxxopts::value<std::string>());
+    Argv av({"test", "--path", "a.txt"});
+    return options.parse(av.argc(), av.argv());
+  };
+
+  auto result = parse();
+  CHECK(result["source"].as<std::string>() == "a.txt");
+  CHECK(result.arguments().front().key() == "file");
+  CHECK_THROWS_WITH(result["name"].as<std::string>(), Catch::Contains("name"));
+}
+
+TEST_CASE("Group help details", "[help]")
+{
+  cxxopts::Options options("test", "Group help details");
+  options.add_options()
+    ("f,file", "File to read", cxxopts::value<std::string>()->default_value("a.txt"), "FILE")
+    ("v,verbose", "Verbose output");
+
+  const auto& group = options.group_help("");
+  REQUIRE(group.options.size() == 2);
+  CHECK(group.options[0].s == "f");
+  CHECK(group.options[0].l == std::vector<std::string>{"file"});
+  CHECK(group.options[0].desc == "File to read");
+  CHECK(group.options[0].has_default);
+  CHECK(group.options[0].default_value == "a.txt");
+  CHECK(group.options[0].arg_help == "FILE");
+  CHECK_FALSE(group.options[0].is_boolean);
+  CHECK(group.options[1].is_boolean);
+
+  // help settings do not move the details, adding an option appends to them
+  options.set_width(100);
+  options.custom_help("[FILE]");
+  CHECK(group.options.size() == 2);
+  options.add_options()("n,count", "Count", cxxopts::value<int>());
+  CHECK(&options.group_help("") == &group);
+  REQUIRE(group.options.size() == 3);
+  CHECK(group.options[2].l == std::vector<std::string>{"count"});
+  CHECK_THROWS_AS(options.group_help("missing"), std::out_of_range);
+}
+
 TEST_CASE("Help output wrapping", "[help]")
 {
   struct {
@@ -1745,6 +2891,36 @@ TEST_CASE("Help output wrapping", "[help]")
       "  -o, --opt  abc\n"
       "             xyz\n"
     },
+#ifndef CXXOPTS_USE_UNICODE
+    {
+      "Wide characters are aligned by their width",
+      cxxopts::Options("prog")
+        .set_width(40)
+        .set_tab_expansion(true),
+      {{"f,file", "\xe5\x85\xa5\xe5\x8a\x9b\tfile"}, {"n,name", "name"}},
+      {},
+      "\n"
+      "Usage:\n"
+      "prog [OPTION...]\n"
+      "\n"
+      "  -f, --file  \xe5\x85\xa5\xe5\x8a\x9b    file\n"
+      "  -n, --name  name\n"
+    },
+#endif
+    {
+      "Tab stops restart after an explicit newline",
+      cxxopts::Options("prog")
+        .set_width(40)
+        .set_tab_expansion(true),
+      {{"o,opt", "abc\tdefghijkl\tm\nn\t\to"}},
+      {},
+      "\n"
+      "Usage:\n"
+      "prog [OPTION...]\n"
+      "\n"
+      "  -o, --opt  abc     defghijkl       m\n"
+      "             n               o\n"
+    },
   };
 
   for (auto& tc : tests)
@@ -1767,10 +2943,10 @@ TEST_CASE("wrap_text", "[wrap_text]")
 {
   struct {
     std::string name;
-    cxxopts::String text;
+    std::string text;
     std::size_t allowed;
     std::size_t start;
-    cxxopts::String expected;
+    std::string expected;
   } tests[] = {
     {
       "Plain Newline",
@@ -1973,14 +3149,112 @@ TEST_CASE("wrap_text", "[wrap_text]")
       2,
       "a\n"
       "\n"
-    }
+    },
+    {
+      "Wide characters take two columns",
+      "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe3\x83\x86\xe3\x82\xad",
+      6,
+      2,
+      "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\n"
+      "  \xe3\x81\xae\xe3\x83\x86\xe3\x82\xad"
+    },
+    {
+      "Wide character that does not fit starts a new line",
+      "a\xe6\x97\xa5\xe6\x9c\xac",
+      2,
+      0,
+      "a\n"
+      "\xe6\x97\xa5\n"
+      "\xe6\x9c\xac"
+    },
+    {
+      "Combining marks take no columns",
+      "e\xcc\x81te\xcc\x81 ab",
+      4,
+      0,
+      "e\xcc\x81te\xcc\x81\n"
+      "ab"
+    },
+    {
+      "Words are not split inside a character",
+      "br\xc3\xbbl\xc3\xa9\x65s",
+      3,
+      0,
+      "br\xc3\xbb\n"
+      "l\xc3\xa9\x65\n"
+      "s"
+    },
+    {
+      "Characters outside the BMP are kept whole",
+      "\xf0\x9f\x98\x80\xf0\x9f\x98\x80\xf0\x9f\x98\x80 a",
+      5,
+      0,
+      "\xf0\x9f\x98\x80\xf0\x9f\x98\x80\n"
+      "\xf0\x9f\x98\x80 a"
+    },
   };
 
   for (auto& tc : tests)
   {
     SECTION(tc.name)
     {
-      CHECK(cxxopts::wrap_text(tc.text, tc.allowed, tc.start) == tc.expected);
+      CHECK(cxxopts::toUTF8String(cxxopts::wrap_text(cxxopts::toLocalString(tc.text),
+        tc.allowed, tc.start)) == tc.expected);
     }
   }
 }
+
+TEST_CASE("Display width of help text", "[wrap_text]")
+{
+  auto width = [](const std::string& text) {
+    return cxxopts::stringLength(cxxopts::toLocalString(text));
+  };
+
+  CHECK(width("abc") == 3);
+  CHECK(width("\xe6\x97\xa5\xe6\x9c\xac") == 4);
+  CHECK(width("\xef\xbc\xa1") == 2);
+  CHECK(width("e\xcc\x81") == 1);
+  CHECK(width("\xf0\x9f\x98\x80") == 2);
+  CHECK(width("\xe2\x82\xac") == 1);
+
+#ifndef CXXOPTS_USE_UNICODE
+  // Bytes that are not UTF-8 take a column each
+  CHECK(width("\xff\xc3(\xe6\x97") == 5);
+  CHECK(width("\xed\xa0\x80") == 3);
+#endif
+}
+
+#ifndef CXXOPTS_USE_UNICODE
+
+TEST_CASE("wrap_text matches the character by character wrapper", "[wrap_text]")
+{
+  // Short words, runs of whitespace and words longer than a 16 byte block
+  const char* pieces[] = {
+    "a", "bc", "def", "ghijklmnopqrstuvwxyz0123456789", " ", "  ", "\t", "\n",
+  };
+
+  std::uint32_t seed = 1;
+  auto next = [&seed](std::uint32_t n) {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) % n;
+  };
+
+  for (int i = 0; i != 2000; ++i)
+  {
+    std::string text;
+    const auto count = next(24);
+    for (std::uint32_t j = 0; j != count; ++j)
+    {
+      text += pieces[next(sizeof(pieces) / sizeof(pieces[0]))];
+    }
+
+    for (std::size_t allowed = 0; allowed != 20; ++allowed)
+    {
+      const std::size_t start = next(4);
+      INFO("text: \"" << text << "\", allowed: " << allowed << ", start: " << start);
+      REQUIRE(cxxopts::wrap_text(text, allowed, start) ==
+        reference_wrap_text(text, allowed, start));
+    }
+  }
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef CXXOPTS_TEST_REFERENCE_WRAP_TEXT_HPP
+#define CXXOPTS_TEST_REFERENCE_WRAP_TEXT_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+// The character by character wrapper that cxxopts::wrap_text replaced for
+// std::string. The tests check wrap_text against it, and the benchmarks use
+// it as the baseline.
+inline
+std::string
+reference_wrap_text(const std::string& text, std::size_t allowed, std::size_t start)
+{
+  if (allowed == 0) return {};
+
+  std::string result;
+  auto current = text.begin();
+  auto startLine = current;
+  auto lastSpace = current;
+  auto contentEnd = current;
+  auto lastSpaceContentEnd = current;
+  std::size_t size = 0;
+  bool firstLine = true;
+
+  auto is_space = [](std::string::const_iterator itr) {
+    return *itr == ' ' || *itr == '\t' || *itr == '\n';
+  };
+
+  auto add_line = [&](std::string::const_iterator begin, std::string::const_iterator end) {
+    if (!firstLine) result += '\n';
+    if (begin != end) {
+      if (!firstLine) result.append(start, ' ');
+      result.append(begin, end);
+    }
+    firstLine = false;
+  };
+
+  auto reset_line_start = [&](std::string::const_iterator itr, std::string::const_iterator lineContentEnd) {
+    startLine = itr;
+    lastSpace = startLine;
+    contentEnd = lineContentEnd;
+    lastSpaceContentEnd = startLine;
+    size = static_cast<std::size_t>(std::distance(startLine, std::next(current)));
+  };
+
+  for (; current != text.end(); ++current)
+  {
+    const auto currentNext = std::next(current);
+
+    if (*current == '\n') {
+      add_line(startLine, contentEnd);
+      reset_line_start(currentNext, currentNext);
+      if (currentNext == text.end()) add_line(currentNext, currentNext);
+      continue;
+    }
+
+    ++size;
+    if (is_space(current)) {
+      lastSpace = current;
+      lastSpaceContentEnd = contentEnd;
+    } else {
+      contentEnd = currentNext;
+    }
+
+    bool endHere = false;
+    auto endLine = contentEnd;
+    auto nextLineStart = currentNext;
+
+    if (currentNext == text.end()) {
+      endHere = true;
+    } else if (is_space(current) && size == 1) {
+      reset_line_start(currentNext, currentNext);
+    } else if (size >= allowed && !is_space(currentNext)) {
+      if (lastSpace != startLine && lastSpace != current) {
+        endLine = lastSpaceContentEnd;
+        nextLineStart = std::next(lastSpace);
+      }
+      endHere = *endLine != '\n';
+    }
+
+    if (endHere) {
+      add_line(startLine, endLine);
+      reset_line_start(nextLineStart, currentNext);
+    }
+  }
+
+  return result;
+}
+
+#endif